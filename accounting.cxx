@@ -0,0 +1,143 @@
+#include "accounting.h"
+
+#include "annals.h"
+#include "stringbuilder.h"
+
+namespace Accounting
+{
+
+static std::atomic<Tag *> &TagHead(void)
+{
+	static std::atomic<Tag *> Head(nullptr);
+	return Head;
+}
+
+Tag::Tag(char const *Name) :
+	Name(Name), LiveBytes(0), LiveCount(0), PeakBytes(0), TotalBytes(0), TotalCount(0), Limit(0),
+	Sampled(false), SampleBytes(0), SampleCount(0), ByteRate(0.0), CountRate(0.0)
+{
+	Next = TagHead().load();
+	while (!TagHead().compare_exchange_weak(Next, this)) {}
+}
+
+void Tag::Charge(size_t Bytes, size_t Count)
+{
+	uint64_t const Live = LiveBytes.fetch_add(Bytes, std::memory_order_relaxed) + Bytes;
+	LiveCount.fetch_add(Count, std::memory_order_relaxed);
+	TotalBytes.fetch_add(Bytes, std::memory_order_relaxed);
+	TotalCount.fetch_add(Count, std::memory_order_relaxed);
+	uint64_t Peak = PeakBytes.load(std::memory_order_relaxed);
+	while ((Live > Peak) && !PeakBytes.compare_exchange_weak(Peak, Live, std::memory_order_relaxed)) {}
+}
+
+void Tag::Refund(size_t Bytes, size_t Count)
+{
+	LiveBytes.fetch_sub(Bytes, std::memory_order_relaxed);
+	LiveCount.fetch_sub(Count, std::memory_order_relaxed);
+}
+
+char const *Tag::GetName(void) const { return Name; }
+
+uint64_t Tag::GetLiveBytes(void) const { return LiveBytes.load(std::memory_order_relaxed); }
+
+uint64_t Tag::GetLiveCount(void) const { return LiveCount.load(std::memory_order_relaxed); }
+
+uint64_t Tag::GetPeakBytes(void) const { return PeakBytes.load(std::memory_order_relaxed); }
+
+uint64_t Tag::GetTotalBytes(void) const { return TotalBytes.load(std::memory_order_relaxed); }
+
+uint64_t Tag::GetTotalCount(void) const { return TotalCount.load(std::memory_order_relaxed); }
+
+void Tag::SetLimit(uint64_t Bytes) { Limit.store(Bytes, std::memory_order_relaxed); }
+
+uint64_t Tag::GetLimit(void) const { return Limit.load(std::memory_order_relaxed); }
+
+bool Tag::IsOverLimit(void) const
+{
+	uint64_t const Bound = GetLimit();
+	return (Bound != 0) && (GetLiveBytes() > Bound);
+}
+
+double Tag::GetByteRate(void) const
+	{ std::lock_guard<std::mutex> Lock(SampleMutex); return ByteRate; }
+
+double Tag::GetCountRate(void) const
+	{ std::lock_guard<std::mutex> Lock(SampleMutex); return CountRate; }
+
+void Tag::TakeSample(std::chrono::steady_clock::time_point Now)
+{
+	std::lock_guard<std::mutex> Lock(SampleMutex);
+	uint64_t const Bytes = GetTotalBytes(), Count = GetTotalCount();
+	if (Sampled)
+	{
+		double const Seconds = std::chrono::duration<double>(Now - SampleTime).count();
+		if (Seconds <= 0.0) return;
+		ByteRate = (Bytes - SampleBytes) / Seconds;
+		CountRate = (Count - SampleCount) / Seconds;
+	}
+	Sampled = true;
+	SampleTime = Now;
+	SampleBytes = Bytes;
+	SampleCount = Count;
+}
+
+Tag const *Tag::GetNext(void) const { return Next; }
+
+Tag const *Tag::GetFirst(void) { return TagHead().load(); }
+
+void Sample(void)
+{
+	std::chrono::steady_clock::time_point const Now = std::chrono::steady_clock::now();
+	for (Tag *Current = TagHead().load(); Current != nullptr; Current = Current->Next) Current->TakeSample(Now);
+}
+
+static void DescribeTag(StringBuilder &Out, Tag const &Described)
+{
+	Out << Described.GetName() << ": " << static_cast<unsigned long>(Described.GetLiveBytes()) << " bytes in " <<
+		static_cast<unsigned long>(Described.GetLiveCount()) << " allocations, peak " <<
+		static_cast<unsigned long>(Described.GetPeakBytes()) << " bytes, " <<
+		static_cast<unsigned long>(Described.GetTotalCount()) << " allocations ever, " <<
+		Described.GetByteRate() << " bytes/s, " << Described.GetCountRate() << " allocations/s";
+	if (Described.GetLimit() != 0) Out << ", limit " << static_cast<unsigned long>(Described.GetLimit());
+}
+
+String Describe(void)
+{
+	StringBuilder Out;
+	for (Tag const *Current = Tag::GetFirst(); Current != nullptr; Current = Current->GetNext())
+	{
+		if (Current->GetTotalCount() == 0) continue;
+		DescribeTag(Out, *Current);
+		Out << "\n";
+	}
+	return Out;
+}
+
+void Log(AnnalsBase &Out) { Log(Out, rlDefault); }
+
+void Log(AnnalsBase &Out, int Level)
+{
+	String const Description = Describe();
+	if (!Description.empty()) Out.Log(Level, "Memory accounting", Description.substr(0, Description.size() - 1));
+	for (Tag const *Current = Tag::GetFirst(); Current != nullptr; Current = Current->GetNext())
+	{
+		if (!Current->IsOverLimit()) continue;
+		StringBuilder Warning;
+		Warning << "Memory tag over its limit: ";
+		DescribeTag(Warning, *Current);
+		Out.Warn(Warning);
+	}
+}
+
+// Never destroyed, so static containers can still refund during exit
+namespace Tags
+{
+	Tag &Pool(void) { static Tag *Instance = new Tag("pool"); return *Instance; }
+	Tag &Factory(void) { static Tag *Instance = new Tag("factory"); return *Instance; }
+	Tag &Club(void) { static Tag *Instance = new Tag("club"); return *Instance; }
+	Tag &Arena(void) { static Tag *Instance = new Tag("arena"); return *Instance; }
+	Tag &Stream(void) { static Tag *Instance = new Tag("memory stream"); return *Instance; }
+	Tag &Deleter(void) { static Tag *Instance = new Tag("deleter"); return *Instance; }
+}
+
+}
@@ -0,0 +1,140 @@
+#ifndef accounting_h
+#define accounting_h
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "string.h"
+
+class AnnalsBase;
+
+/*
+Memory accounting by tag.
+
+	static Accounting::Tag MeshTag("meshes");
+	std::vector<Vertex, Accounting::TaggedAllocator<Vertex> > Vertices(Accounting::TaggedAllocator<Vertex>(MeshTag));
+	...
+	Accounting::Sample(); // Now and then, for allocation rates
+	Accounting::Log(GeneralAnnals());
+
+Tags count live bytes and allocations, the high-water mark of live bytes and lifetime totals, from
+any thread.  TaggedAllocator and explicit Charge/Refund calls always count.  The library's own
+containers (pools, factories, clubs, deleters, arenas and memory streams) only report to their
+built-in tags when RENGENERAL_MEMORY_ACCOUNTING is defined, which must be the same for the whole
+build.  Sizes for pools, factories, clubs and deleters are the sizes of the static types they
+hold, not counting derived types or the containers' own bookkeeping.
+*/
+
+namespace Accounting
+{
+
+class Tag
+{
+	public:
+		Tag(char const *Name); // Must have static storage duration
+		Tag(Tag const &Other) = delete;
+		Tag &operator =(Tag const &Other) = delete;
+
+		void Charge(size_t Bytes, size_t Count = 1);
+		void Refund(size_t Bytes, size_t Count = 1);
+
+		char const *GetName(void) const;
+		uint64_t GetLiveBytes(void) const;
+		uint64_t GetLiveCount(void) const;
+		uint64_t GetPeakBytes(void) const;
+		uint64_t GetTotalBytes(void) const; // Ever charged
+		uint64_t GetTotalCount(void) const;
+
+		// Live bytes above the limit are reported as a warning by Log; 0 is no limit
+		void SetLimit(uint64_t Bytes);
+		uint64_t GetLimit(void) const;
+		bool IsOverLimit(void) const;
+
+		// Charges per second between the last two calls to Accounting::Sample
+		double GetByteRate(void) const;
+		double GetCountRate(void) const;
+
+		Tag const *GetNext(void) const; // Newest first
+		static Tag const *GetFirst(void);
+
+	private:
+		friend void Sample(void);
+		void TakeSample(std::chrono::steady_clock::time_point Now);
+
+		char const *Name;
+		std::atomic<uint64_t> LiveBytes, LiveCount, PeakBytes, TotalBytes, TotalCount, Limit;
+
+		mutable std::mutex SampleMutex;
+		bool Sampled;
+		std::chrono::steady_clock::time_point SampleTime;
+		uint64_t SampleBytes, SampleCount;
+		double ByteRate, CountRate;
+
+		Tag *Next;
+};
+
+// Updates every tag's allocation rates
+void Sample(void);
+
+// One line per tag that has been charged.  Log also warns about tags over their limit; without a
+// level it logs at rlDefault.  annals.h isn't included here since container headers include this.
+String Describe(void);
+void Log(AnnalsBase &Out);
+void Log(AnnalsBase &Out, int Level);
+
+// Built-in tags for the library's containers
+namespace Tags
+{
+	Tag &Pool(void);
+	Tag &Factory(void);
+	Tag &Club(void);
+	Tag &Arena(void);
+	Tag &Stream(void);
+	Tag &Deleter(void);
+}
+
+// Hooks for the library's containers, empty unless accounting is enabled
+#ifdef RENGENERAL_MEMORY_ACCOUNTING
+inline void Charge(Tag &Charged, size_t Bytes, size_t Count = 1) { Charged.Charge(Bytes, Count); }
+inline void Refund(Tag &Refunded, size_t Bytes, size_t Count = 1) { Refunded.Refund(Bytes, Count); }
+#else
+inline void Charge(Tag &, size_t, size_t = 1) {}
+inline void Refund(Tag &, size_t, size_t = 1) {}
+#endif
+
+template <typename Type> class TaggedAllocator
+{
+	public:
+		typedef Type value_type;
+
+		TaggedAllocator(Tag &Charged) : Charged(&Charged) {}
+		template <typename OtherType> TaggedAllocator(TaggedAllocator<OtherType> const &Other) : Charged(Other.Charged) {}
+
+		Type *allocate(size_t Count)
+		{
+			Type *Out = static_cast<Type *>(::operator new(Count * sizeof(Type)));
+			Charged->Charge(Count * sizeof(Type));
+			return Out;
+		}
+
+		void deallocate(Type *Freed, size_t Count)
+		{
+			Charged->Refund(Count * sizeof(Type));
+			::operator delete(Freed);
+		}
+
+		template <typename OtherType> bool operator ==(TaggedAllocator<OtherType> const &Other) const { return Charged == Other.Charged; }
+		template <typename OtherType> bool operator !=(TaggedAllocator<OtherType> const &Other) const { return Charged != Other.Charged; }
+
+	private:
+		template <typename OtherType> friend class TaggedAllocator;
+		Tag *Charged;
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #include "annals.h"
 
 #include "string.h"
+#include "stringbuilder.h"
 
 #include <iostream>
 #include <stdlib.h>
@@ -54,7 +55,7 @@ void AnnalsBase::Log(int Level, const String &Message, String Extra)
 	//String Timestamp = asctime(localtime(&GlobalTime));
 	//Timestamp = Timestamp.erase(Timestamp.find("\n"));
 
-	MemoryStream Rendered;
+	StringBuilder Rendered;
 	//Rendered << Timestamp << ", ";
 
 	if (Level == rlFatalErrors) Rendered << "Fatal Error ";
@@ -65,14 +66,20 @@ void AnnalsBase::Log(int Level, const String &Message, String Extra)
 
 	if (!Extra.empty())
 	{
-		String::size_type LastFind = 0;
-		while ((LastFind = Extra.find("\n", LastFind + 1)) != String::npos)
-			Extra.insert(LastFind + 1, "\t");
-		Rendered << "\t" << Extra << "\n";
+		// Indent every line of the extra text
+		Rendered << "\t";
+		String::size_type Start = 0, LastFind;
+		while ((LastFind = Extra.find("\n", (Start == 0) ? 1 : Start)) != String::npos)
+		{
+			Rendered.Append(Extra.data() + Start, LastFind + 1 - Start) << "\t";
+			Start = LastFind + 1;
+		}
+		Rendered.Append(Extra.data() + Start, Extra.size() - Start) << "\n";
 	}
 
-	if (Level >= FileLevel) FileOutputInstance << (String)Rendered << OutputStream::Flush();
-	if (Level >= ConsoleLevel) StandardStream << (String)Rendered << OutputStream::Flush();
+	String const Output = Rendered;
+	if (Level >= FileLevel) FileOutputInstance << Output << OutputStream::Flush();
+	if (Level >= ConsoleLevel) StandardStream << Output << OutputStream::Flush();
 }
 
 // Convenience functions
@@ -4,7 +4,18 @@
 #include <cassert>
 #include <set>
 #include <vector>
+#include <unordered_map>
 #include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <new>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "collection.h"
+#include "parallel.h"
 
 template <typename SetType> class Set : public std::set<SetType>
 {
@@ -39,88 +50,726 @@ template <typename SetType> class Set : public std::set<SetType>
 			{ return std::set<SetType>::find(Element) != std::set<SetType>::end(); }
 };
 
+// Set algebra on sorted arrays.  Integer and pointer elements of 4 or 8 bytes are compared a block
+// at a time with SSE2: every element of a block of A against every element of a block of B.
+namespace SortedAlgebra
+{
+	template <typename ElementType> struct BlockWidth
+	{
+#ifdef __SSE2__
+		static size_t const Value = !(std::is_integral<ElementType>::value || std::is_pointer<ElementType>::value) ? 0 :
+			sizeof(ElementType) == 4 ? 4 :
+			sizeof(ElementType) == 8 ? 2 :
+			0;
+#else
+		static size_t const Value = 0;
+#endif
+	};
+
+	template <size_t Width> struct Block;
+
+#ifdef __SSE2__
+	// Bit N is set if A[N] equals any element of B
+	template <> struct Block<4>
+	{
+		static unsigned int Matches(void const *A, void const *B)
+		{
+			__m128i const Left = _mm_loadu_si128(static_cast<__m128i const *>(A));
+			__m128i const Right = _mm_loadu_si128(static_cast<__m128i const *>(B));
+			__m128i Equal = _mm_cmpeq_epi32(Left, Right);
+			Equal = _mm_or_si128(Equal, _mm_cmpeq_epi32(Left, _mm_shuffle_epi32(Right, _MM_SHUFFLE(0, 3, 2, 1))));
+			Equal = _mm_or_si128(Equal, _mm_cmpeq_epi32(Left, _mm_shuffle_epi32(Right, _MM_SHUFFLE(1, 0, 3, 2))));
+			Equal = _mm_or_si128(Equal, _mm_cmpeq_epi32(Left, _mm_shuffle_epi32(Right, _MM_SHUFFLE(2, 1, 0, 3))));
+			return _mm_movemask_ps(_mm_castsi128_ps(Equal));
+		}
+	};
+
+	template <> struct Block<2>
+	{
+		static __m128i Equal64(__m128i Left, __m128i Right)
+		{
+			__m128i const Halves = _mm_cmpeq_epi32(Left, Right);
+			return _mm_and_si128(Halves, _mm_shuffle_epi32(Halves, _MM_SHUFFLE(2, 3, 0, 1)));
+		}
+
+		static unsigned int Matches(void const *A, void const *B)
+		{
+			__m128i const Left = _mm_loadu_si128(static_cast<__m128i const *>(A));
+			__m128i const Right = _mm_loadu_si128(static_cast<__m128i const *>(B));
+			__m128i const Equal = _mm_or_si128(Equal64(Left, Right),
+				Equal64(Left, _mm_shuffle_epi32(Right, _MM_SHUFFLE(1, 0, 3, 2))));
+			return _mm_movemask_pd(_mm_castsi128_pd(Equal));
+		}
+	};
+#endif
+
+	// Appends to Out the elements of A that are (Keep) or aren't (!Keep) also in B
+	template <typename ElementType, size_t Width = BlockWidth<ElementType>::Value> struct Filter
+	{
+		static void Run(ElementType const *A, size_t ACount, ElementType const *B, size_t BCount, bool Keep, std::vector<ElementType> &Out)
+		{
+			if (Keep) std::set_intersection(A, A + ACount, B, B + BCount, std::back_inserter(Out));
+			else std::set_difference(A, A + ACount, B, B + BCount, std::back_inserter(Out));
+		}
+	};
+
+	template <typename ElementType, size_t Width> struct BlockFilter
+	{
+		static void Run(ElementType const *A, size_t ACount, ElementType const *B, size_t BCount, bool Keep, std::vector<ElementType> &Out)
+		{
+			size_t AIndex = 0, BIndex = 0;
+			unsigned int Matched = 0; // Accumulated over the B blocks seen by the current A block
+			while ((AIndex + Width <= ACount) && (BIndex + Width <= BCount))
+			{
+				Matched |= Block<Width>::Matches(A + AIndex, B + BIndex);
+				ElementType const ALast = A[AIndex + Width - 1], BLast = B[BIndex + Width - 1];
+				if (!(BLast < ALast))
+				{
+					for (size_t Offset = 0; Offset < Width; Offset++)
+						if (((Matched >> Offset) & 1) == Keep) Out.push_back(A[AIndex + Offset]);
+					Matched = 0;
+					AIndex += Width;
+				}
+				if (!(ALast < BLast)) BIndex += Width;
+			}
+
+			for (size_t Offset = 0; AIndex < ACount; AIndex++, Offset++)
+			{
+				while ((BIndex < BCount) && (B[BIndex] < A[AIndex])) BIndex++;
+				bool const Found = ((Offset < Width) && ((Matched >> Offset) & 1)) ||
+					((BIndex < BCount) && !(A[AIndex] < B[BIndex]));
+				if (Found == Keep) Out.push_back(A[AIndex]);
+			}
+		}
+	};
+
+	template <typename ElementType> struct Filter<ElementType, 4> : BlockFilter<ElementType, 4> {};
+	template <typename ElementType> struct Filter<ElementType, 2> : BlockFilter<ElementType, 2> {};
+
+	template <typename ElementType> void Intersect(std::vector<ElementType> const &A, std::vector<ElementType> const &B, std::vector<ElementType> &Out)
+		{ Filter<ElementType>::Run(A.data(), A.size(), B.data(), B.size(), true, Out); }
+
+	template <typename ElementType> void Subtract(std::vector<ElementType> const &A, std::vector<ElementType> const &B, std::vector<ElementType> &Out)
+		{ Filter<ElementType>::Run(A.data(), A.size(), B.data(), B.size(), false, Out); }
+
+	template <typename ElementType> void Unite(std::vector<ElementType> const &A, std::vector<ElementType> const &B, std::vector<ElementType> &Out)
+	{
+		std::vector<ElementType> OnlyB;
+		Subtract(B, A, OnlyB);
+		Out.resize(A.size() + OnlyB.size());
+		std::merge(A.begin(), A.end(), OnlyB.begin(), OnlyB.end(), Out.begin());
+	}
+}
+
+// FlatSet has the interface of Set, but keeps its elements sorted in one array.  Lookups are
+// binary searches and set operations are linear merges, so it suits sets that are built in bulk
+// and queried often more than sets that are modified one element at a time.
+template <typename SetType> class FlatSet
+{
+	public:
+		typedef typename std::vector<SetType>::const_iterator iterator;
+		typedef typename std::vector<SetType>::const_iterator const_iterator;
+
+		FlatSet(void) {}
+
+		FlatSet(SetType const &Element) : Elements(1, Element) {}
+
+		FlatSet(std::initializer_list<SetType> Elements) : Elements(Elements) { Normalize(); }
+
+		template <typename IteratorType> FlatSet(IteratorType Start, IteratorType End) : Elements(Start, End) { Normalize(); }
+
+		FlatSet(std::vector<SetType> &&Unsorted) : Elements(std::move(Unsorted)) { Normalize(); }
+
+		FlatSet<SetType> &And(FlatSet<SetType> const &Object)
+		{
+			std::vector<SetType> Out;
+			SortedAlgebra::Unite(Elements, Object.Elements, Out);
+			Elements.swap(Out);
+			return *this;
+		}
+
+		FlatSet<SetType> &And(SetType const &Element)
+		{
+			insert(Element);
+			return *this;
+		}
+
+		FlatSet<SetType> &operator=(SetType const &Element)
+		{
+			Elements.assign(1, Element);
+			return *this;
+		}
+
+		bool Contains(SetType const &Element) const
+		{
+			// Branchless lower bound: the loop always runs log2(size) times and the
+			// comparison compiles to a conditional move.
+			size_t Length = Elements.size();
+			if (Length == 0) return false;
+			SetType const *Base = Elements.data();
+			while (Length > 1)
+			{
+				size_t const Half = Length / 2;
+				Base = !(Element < Base[Half]) ? Base + Half : Base;
+				Length -= Half;
+			}
+			return !(*Base < Element) && !(Element < *Base);
+		}
+
+		FlatSet<SetType> Intersection(FlatSet<SetType> const &Object) const
+		{
+			FlatSet<SetType> Out;
+			SortedAlgebra::Intersect(Elements, Object.Elements, Out.Elements);
+			return Out;
+		}
+
+		FlatSet<SetType> Union(FlatSet<SetType> const &Object) const
+		{
+			FlatSet<SetType> Out;
+			SortedAlgebra::Unite(Elements, Object.Elements, Out.Elements);
+			return Out;
+		}
+
+		FlatSet<SetType> Difference(FlatSet<SetType> const &Object) const
+		{
+			FlatSet<SetType> Out;
+			SortedAlgebra::Subtract(Elements, Object.Elements, Out.Elements);
+			return Out;
+		}
+
+		std::pair<const_iterator, bool> insert(SetType const &Element)
+		{
+			auto Position = std::lower_bound(Elements.begin(), Elements.end(), Element);
+			if ((Position != Elements.end()) && !(Element < *Position)) return std::make_pair(const_iterator(Position), false);
+			return std::make_pair(const_iterator(Elements.insert(Position, Element)), true);
+		}
+
+		size_t erase(SetType const &Element)
+		{
+			auto Position = std::lower_bound(Elements.begin(), Elements.end(), Element);
+			if ((Position == Elements.end()) || (Element < *Position)) return 0;
+			Elements.erase(Position);
+			return 1;
+		}
+
+		const_iterator find(SetType const &Element) const
+		{
+			auto Position = std::lower_bound(Elements.begin(), Elements.end(), Element);
+			if ((Position == Elements.end()) || (Element < *Position)) return Elements.end();
+			return Position;
+		}
+
+		size_t count(SetType const &Element) const { return Contains(Element) ? 1 : 0; }
+		const_iterator begin(void) const { return Elements.begin(); }
+		const_iterator end(void) const { return Elements.end(); }
+		size_t size(void) const { return Elements.size(); }
+		bool empty(void) const { return Elements.empty(); }
+		void clear(void) { Elements.clear(); }
+		void reserve(size_t Count) { Elements.reserve(Count); }
+		bool operator ==(FlatSet<SetType> const &Other) const { return Elements == Other.Elements; }
+		bool operator !=(FlatSet<SetType> const &Other) const { return Elements != Other.Elements; }
+
+	private:
+		void Normalize(void)
+		{
+			std::sort(Elements.begin(), Elements.end());
+			Elements.erase(std::unique(Elements.begin(), Elements.end(),
+				[](SetType const &First, SetType const &Second) { return !(First < Second) && !(Second < First); }),
+				Elements.end());
+		}
+
+		std::vector<SetType> Elements;
+};
+
+// SmallArray keeps up to InlineCount elements inside itself and moves them to the heap when it
+// grows past that.  It backs SmallSet and SmallMap.
+template <typename ElementType, size_t InlineCount> class SmallArray
+{
+	public:
+		SmallArray(void) : Data(Inline()), Count(0), Capacity(InlineCount) {}
+
+		SmallArray(SmallArray<ElementType, InlineCount> const &Other) : Data(Inline()), Count(0), Capacity(InlineCount)
+		{
+			Reserve(Other.Count);
+			for (size_t Index = 0; Index < Other.Count; Index++) new (Data + Index) ElementType(Other.Data[Index]);
+			Count = Other.Count;
+		}
+
+		SmallArray(SmallArray<ElementType, InlineCount> &&Other) : Data(Inline()), Count(0), Capacity(InlineCount)
+			{ Take(Other); }
+
+		~SmallArray(void) { Release(); }
+
+		SmallArray<ElementType, InlineCount> &operator =(SmallArray<ElementType, InlineCount> const &Other)
+		{
+			if (&Other == this) return *this;
+			clear();
+			Reserve(Other.Count);
+			for (size_t Index = 0; Index < Other.Count; Index++) new (Data + Index) ElementType(Other.Data[Index]);
+			Count = Other.Count;
+			return *this;
+		}
+
+		SmallArray<ElementType, InlineCount> &operator =(SmallArray<ElementType, InlineCount> &&Other)
+		{
+			if (&Other == this) return *this;
+			Release();
+			Data = Inline();
+			Count = 0;
+			Capacity = InlineCount;
+			Take(Other);
+			return *this;
+		}
+
+		void push_back(ElementType const &Element)
+		{
+			if (Count == Capacity)
+			{
+				ElementType Copy(Element); // Element may live in this array
+				Reserve(std::max<size_t>(Capacity * 2, 1));
+				new (Data + Count) ElementType(std::move(Copy));
+			}
+			else new (Data + Count) ElementType(Element);
+			Count++;
+		}
+
+		// Keeps the order of the remaining elements
+		void erase(size_t Position)
+		{
+			assert(Position < Count);
+			for (size_t Index = Position + 1; Index < Count; Index++) Data[Index - 1] = std::move(Data[Index]);
+			Data[--Count].~ElementType();
+		}
+
+		void clear(void)
+		{
+			for (size_t Index = 0; Index < Count; Index++) Data[Index].~ElementType();
+			Count = 0;
+		}
+
+		void Reserve(size_t Needed)
+		{
+			if (Needed <= Capacity) return;
+			ElementType *Grown = static_cast<ElementType *>(::operator new(Needed * sizeof(ElementType)));
+			for (size_t Index = 0; Index < Count; Index++)
+			{
+				new (Grown + Index) ElementType(std::move(Data[Index]));
+				Data[Index].~ElementType();
+			}
+			if (Data != Inline()) ::operator delete(Data);
+			Data = Grown;
+			Capacity = Needed;
+		}
+
+		ElementType *begin(void) { return Data; }
+		ElementType *end(void) { return Data + Count; }
+		ElementType const *begin(void) const { return Data; }
+		ElementType const *end(void) const { return Data + Count; }
+		ElementType &operator [](size_t Index) { return Data[Index]; }
+		ElementType const &operator [](size_t Index) const { return Data[Index]; }
+		size_t size(void) const { return Count; }
+		bool empty(void) const { return Count == 0; }
+		bool IsInline(void) const { return Data == Inline(); }
+
+	private:
+		ElementType *Inline(void) { return reinterpret_cast<ElementType *>(&Buffer); }
+		ElementType const *Inline(void) const { return reinterpret_cast<ElementType const *>(&Buffer); }
+
+		void Release(void)
+		{
+			clear();
+			if (Data != Inline()) ::operator delete(Data);
+		}
+
+		void Take(SmallArray<ElementType, InlineCount> &Other)
+		{
+			if (!Other.IsInline())
+			{
+				Data = Other.Data;
+				Count = Other.Count;
+				Capacity = Other.Capacity;
+				Other.Data = Other.Inline();
+				Other.Count = 0;
+				Other.Capacity = InlineCount;
+				return;
+			}
+			for (size_t Index = 0; Index < Other.Count; Index++) new (Data + Index) ElementType(std::move(Other.Data[Index]));
+			Count = Other.Count;
+			Other.clear();
+		}
+
+		typename std::aligned_storage<sizeof(ElementType) * InlineCount, alignof(ElementType)>::type Buffer;
+		ElementType *Data;
+		size_t Count, Capacity;
+};
+
+// Linear search over a short array.  Integer and pointer elements are compared 16 bytes at a time
+// with SSE2.
+template <typename ElementType, size_t Width = (std::is_integral<ElementType>::value || std::is_pointer<ElementType>::value) ? sizeof(ElementType) : 0>
+	struct LinearSearch
+{
+	static size_t Find(ElementType const *Data, size_t Count, ElementType const &Target)
+	{
+		for (size_t Index = 0; Index < Count; Index++)
+			if (Data[Index] == Target) return Index;
+		return Count;
+	}
+};
+
+#ifdef __SSE2__
+template <typename ElementType, size_t Width> struct VectorLinearSearch
+{
+	static __m128i Broadcast(ElementType const &Target)
+	{
+		__m128i Out;
+		for (size_t Offset = 0; Offset < 16; Offset += Width) memcpy(reinterpret_cast<char *>(&Out) + Offset, &Target, Width);
+		return Out;
+	}
+
+	static __m128i Equal(__m128i Left, __m128i Right)
+	{
+		switch (Width)
+		{
+			case 1: return _mm_cmpeq_epi8(Left, Right);
+			case 2: return _mm_cmpeq_epi16(Left, Right);
+			case 4: return _mm_cmpeq_epi32(Left, Right);
+			default:
+			{
+				__m128i const Halves = _mm_cmpeq_epi32(Left, Right);
+				return _mm_and_si128(Halves, _mm_shuffle_epi32(Halves, _MM_SHUFFLE(2, 3, 0, 1)));
+			}
+		}
+	}
+
+	static size_t Find(ElementType const *Data, size_t Count, ElementType const &Target)
+	{
+		size_t const PerBlock = 16 / Width;
+		__m128i const Needle = Broadcast(Target);
+		size_t Index = 0;
+		for (; Index + PerBlock <= Count; Index += PerBlock)
+		{
+			int const Mask = _mm_movemask_epi8(Equal(_mm_loadu_si128(reinterpret_cast<__m128i const *>(Data + Index)), Needle));
+			if (Mask != 0) return Index + __builtin_ctz(Mask) / Width;
+		}
+		for (; Index < Count; Index++)
+			if (Data[Index] == Target) return Index;
+		return Count;
+	}
+};
+
+template <typename ElementType> struct LinearSearch<ElementType, 1> : VectorLinearSearch<ElementType, 1> {};
+template <typename ElementType> struct LinearSearch<ElementType, 2> : VectorLinearSearch<ElementType, 2> {};
+template <typename ElementType> struct LinearSearch<ElementType, 4> : VectorLinearSearch<ElementType, 4> {};
+template <typename ElementType> struct LinearSearch<ElementType, 8> : VectorLinearSearch<ElementType, 8> {};
+#endif
+
+// SmallSet has the interface of Set but stores up to InlineCount elements without allocating.
+// Elements are unordered and found by linear search, so it's meant for sets of a handful of
+// elements.
+template <typename SetType, size_t InlineCount = 8> class SmallSet
+{
+	public:
+		typedef SetType const *iterator;
+		typedef SetType const *const_iterator;
+
+		SmallSet(void) {}
+
+		SmallSet(SetType const &Element)
+			{ Elements.push_back(Element); }
+
+		SmallSet(std::initializer_list<SetType> Elements)
+			{ for (auto &Element : Elements) insert(Element); }
+
+		SmallSet<SetType, InlineCount> &And(SmallSet<SetType, InlineCount> const &Object)
+		{
+			for (auto &Element : Object) insert(Element);
+			return *this;
+		}
+
+		SmallSet<SetType, InlineCount> &And(SetType const &Element)
+		{
+			insert(Element);
+			return *this;
+		}
+
+		SmallSet<SetType, InlineCount> &operator=(SetType const &Element)
+		{
+			Elements.clear();
+			Elements.push_back(Element);
+			return *this;
+		}
+
+		bool Contains(SetType const &Element) const
+			{ return Position(Element) != Elements.size(); }
+
+		std::pair<const_iterator, bool> insert(SetType const &Element)
+		{
+			size_t const Found = Position(Element);
+			if (Found != Elements.size()) return std::make_pair(Elements.begin() + Found, false);
+			Elements.push_back(Element);
+			return std::make_pair(Elements.end() - 1, true);
+		}
+
+		size_t erase(SetType const &Element)
+		{
+			size_t const Found = Position(Element);
+			if (Found == Elements.size()) return 0;
+			Elements.erase(Found);
+			return 1;
+		}
+
+		const_iterator find(SetType const &Element) const { return Elements.begin() + Position(Element); }
+		size_t count(SetType const &Element) const { return Contains(Element) ? 1 : 0; }
+		const_iterator begin(void) const { return Elements.begin(); }
+		const_iterator end(void) const { return Elements.end(); }
+		size_t size(void) const { return Elements.size(); }
+		bool empty(void) const { return Elements.empty(); }
+		void clear(void) { Elements.clear(); }
+
+	private:
+		size_t Position(SetType const &Element) const
+			{ return LinearSearch<SetType>::Find(Elements.begin(), Elements.size(), Element); }
+
+		SmallArray<SetType, InlineCount> Elements;
+};
+
+// SmallMap stores up to InlineCount entries without allocating.  Keys and values are kept in
+// separate arrays so key searches can be vectorized; iterating yields Entry values holding
+// references to a key and its value.
+template <typename KeyType, typename ValueType, size_t InlineCount = 8> class SmallMap
+{
+	public:
+		struct Entry
+		{
+			KeyType const &first;
+			ValueType &second;
+		};
+
+		class Iterator
+		{
+			public:
+				Iterator(SmallMap<KeyType, ValueType, InlineCount> &Base, size_t Position) : Base(Base), Position(Position) {}
+				void operator++(void) { Position++; }
+				bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+				Entry operator*(void) const { return Entry {Base.Keys[Position], Base.Values[Position]}; }
+			private:
+				SmallMap<KeyType, ValueType, InlineCount> &Base;
+				size_t Position;
+		};
+
+		ValueType &operator [](KeyType const &Key)
+		{
+			size_t const Found = Position(Key);
+			if (Found != Keys.size()) return Values[Found];
+			Keys.push_back(Key);
+			Values.push_back(ValueType());
+			return Values[Found];
+		}
+
+		// Returns nullptr if Key isn't present
+		ValueType *Get(KeyType const &Key)
+		{
+			size_t const Found = Position(Key);
+			return Found == Keys.size() ? nullptr : &Values[Found];
+		}
+
+		ValueType const *Get(KeyType const &Key) const
+		{
+			size_t const Found = Position(Key);
+			return Found == Keys.size() ? nullptr : &Values[Found];
+		}
+
+		bool Contains(KeyType const &Key) const { return Position(Key) != Keys.size(); }
+
+		size_t erase(KeyType const &Key)
+		{
+			size_t const Found = Position(Key);
+			if (Found == Keys.size()) return 0;
+			Keys.erase(Found);
+			Values.erase(Found);
+			return 1;
+		}
+
+		Iterator begin(void) { return Iterator(*this, 0); }
+		Iterator end(void) { return Iterator(*this, Keys.size()); }
+		size_t size(void) const { return Keys.size(); }
+		bool empty(void) const { return Keys.empty(); }
+		void clear(void) { Keys.clear(); Values.clear(); }
+
+	private:
+		size_t Position(KeyType const &Key) const
+			{ return LinearSearch<KeyType>::Find(Keys.begin(), Keys.size(), Key); }
+
+		SmallArray<KeyType, InlineCount> Keys;
+		SmallArray<ValueType, InlineCount> Values;
+};
+
 // Only has queries for to-side, but reverse A and B to if the opposite queries are more important.
+// A and B are indexed by hash, so lookups don't depend on the number of objects.  Freeze produces
+// a compact read-only copy for iterating when the connections won't change for a while.
 template <typename AType, typename BType> class ManyToOneMapper
 {
 	private:
 		typedef std::pair<BType *, std::vector<AType *> > Pair;
-		std::vector<AType *> A; // Used only for debug checks
 		std::vector<Pair> Mappings;
+		std::unordered_map<BType const *, size_t> BPositions; // Index into Mappings
+		std::unordered_map<AType const *, std::vector<BType *> > AConnections; // Reverse index, also used to check A
 
 		bool HasA(AType const &TestA) const
-			{ return std::find(A.begin(), A.end(), &TestA) != A.end(); }
+			{ return AConnections.find(&TestA) != AConnections.end(); }
 
 		bool HasB(BType const &TestB) const
+			{ return BPositions.find(&TestB) != BPositions.end(); }
+
+		Pair &Find(BType const &TestB)
+			{ return Mappings[BPositions.find(&TestB)->second]; }
+
+		template <typename ElementType> static void EraseFrom(std::vector<ElementType *> &From, ElementType *Target)
 		{
-			return std::find_if(Mappings.begin(), Mappings.end(),
-				[&TestB](Pair const &Element) { return Element.first == &TestB; }) != Mappings.end();
+			auto Position = std::find(From.begin(), From.end(), Target);
+			assert(Position != From.end());
+			From.erase(Position);
 		}
 
 	public:
+		// Compressed sparse row copy of the mappings.  Groups keep the order of the mapper.
+		class Frozen
+		{
+			public:
+				struct Group
+				{
+					BType *B;
+					IteratorRange<AType *const *> A;
+				};
+
+				class Iterator
+				{
+					public:
+						Iterator(Frozen const &Base, size_t Position) : Base(Base), Position(Position) {}
+						void operator++(void) { Position++; }
+						bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+						Group operator*(void) const { return Base.GetValue(Position); }
+					private:
+						Frozen const &Base;
+						size_t Position;
+				};
+
+				size_t GetCount(void) const { return B.size(); }
+				Group GetValue(size_t Index) const
+				{
+					AType *const *First = A.data();
+					return Group {B[Index], IteratorRange<AType *const *>(First + Offsets[Index], First + Offsets[Index + 1])};
+				}
+
+				Iterator begin(void) const { return Iterator(*this, 0); }
+				Iterator end(void) const { return Iterator(*this, B.size()); }
+
+			private:
+				friend class ManyToOneMapper<AType, BType>;
+				std::vector<BType *> B;
+				std::vector<size_t> Offsets; // Group i's As are [Offsets[i], Offsets[i + 1])
+				std::vector<AType *> A;
+		};
+
 		// Construction
 		void AddA(AType &NewA)
 		{
 			assert(!HasA(NewA));
-			A.push_back(&NewA);
+			AConnections[&NewA];
 		}
 
 		void AddB(BType &NewB)
 		{
 			assert(!HasB(NewB));
+			BPositions[&NewB] = Mappings.size();
 			Mappings.push_back(Pair(&NewB, std::vector<AType *>()));
 		}
 
 		void RemoveA(AType &Target)
 		{
 			assert(HasA(Target));
-
-			for (auto &CurrentMapping : Mappings)
+			auto Connections = AConnections.find(&Target);
+			for (auto ConnectedB : Connections->second)
 			{
-				auto APosition = std::find(CurrentMapping.second.begin(), CurrentMapping.second.end(), &Target);
-				if (APosition == CurrentMapping.second.end())
-					continue;
-
-				CurrentMapping.second.erase(APosition);
-
-				assert(std::find(CurrentMapping.second.begin(), CurrentMapping.second.end(), &Target) == CurrentMapping.second.end());
+				auto &BMappings = Find(*ConnectedB).second;
+				EraseFrom(BMappings, &Target);
+				assert(std::find(BMappings.begin(), BMappings.end(), &Target) == BMappings.end());
 			}
-
-			A.erase(std::find(A.begin(), A.end(), &Target));
+			AConnections.erase(Connections);
 		}
 
 		void RemoveB(BType &Target)
 		{
 			assert(HasB(Target));
-			auto TargetPosition = std::find_if(Mappings.begin(), Mappings.end(),
-				[&Target](Pair const &Element) { return Element.first == &Target; });
-			Mappings.erase(TargetPosition);
+			auto Position = BPositions.find(&Target);
+			size_t const Index = Position->second;
+			for (auto ConnectedA : Mappings[Index].second)
+				EraseFrom(AConnections.find(ConnectedA)->second, &Target);
+			BPositions.erase(Position);
+			Mappings.erase(Mappings.begin() + Index);
+			for (size_t Later = Index; Later < Mappings.size(); Later++)
+				BPositions.find(Mappings[Later].first)->second = Later;
 		}
 
 		void Disconnect(void)
 		{
 			for (auto &CurrentMapping : Mappings)
 				CurrentMapping.second.clear();
+			for (auto &CurrentConnections : AConnections)
+				CurrentConnections.second.clear();
 		}
 
 		void Connect(AType &A, BType &B)
 		{
 			assert(HasA(A));
 			assert(HasB(B));
-			auto BMappings = std::find_if(Mappings.begin(), Mappings.end(),
-				[&B](Pair const &Element) { return Element.first == &B; });
-			assert(std::find(BMappings->second.begin(), BMappings->second.end(), &A) == BMappings->second.end());
-			BMappings->second.push_back(&A);
+			auto &BMappings = Find(B).second;
+			assert(std::find(BMappings.begin(), BMappings.end(), &A) == BMappings.end());
+			BMappings.push_back(&A);
+			AConnections.find(&A)->second.push_back(&B);
 		}
 
+		// Replaces all connections with an array of (A, B) pairs.  The pairs are grouped by B with a
+		// counting sort, and each B's As keep their order in the array.  Pairs must be unique.
+		void Connect(std::pair<AType *, BType *> const *Connections, size_t Count)
+		{
+			Disconnect();
+			std::vector<size_t> Groups(Count);
+			std::vector<size_t> Sizes(Mappings.size(), 0);
+			for (size_t Index = 0; Index < Count; Index++)
+			{
+				assert(HasA(*Connections[Index].first));
+				assert(HasB(*Connections[Index].second));
+				Groups[Index] = BPositions.find(Connections[Index].second)->second;
+				Sizes[Groups[Index]]++;
+			}
+
+			for (size_t Group = 0; Group < Mappings.size(); Group++)
+				Mappings[Group].second.reserve(Sizes[Group]);
+			for (size_t Index = 0; Index < Count; Index++)
+			{
+				Mappings[Groups[Index]].second.push_back(Connections[Index].first);
+				AConnections.find(Connections[Index].first)->second.push_back(Connections[Index].second);
+			}
+#ifndef NDEBUG
+			for (auto &CurrentMapping : Mappings)
+			{
+				std::vector<AType *> Sorted(CurrentMapping.second);
+				std::sort(Sorted.begin(), Sorted.end());
+				assert(std::adjacent_find(Sorted.begin(), Sorted.end()) == Sorted.end());
+			}
+#endif
+		}
+
+		void Connect(std::vector<std::pair<AType *, BType *> > const &Connections)
+			{ Connect(Connections.data(), Connections.size()); }
+
 		void Disconnect(AType &A, BType &B)
 		{
 			assert(HasA(A));
 			assert(HasB(B));
-			auto BMappings = std::find_if(Mappings.begin(), Mappings.end(),
-				[&B](Pair const &Element) { return Element.first == &B; });
-			auto APosition = std::find(BMappings->second.begin(), BMappings->second.end(), &A);
-			assert(APosition != BMappings->second.end());
-			BMappings->second.erase(APosition);
+			EraseFrom(Find(B).second, &A);
+			EraseFrom(AConnections.find(&A)->second, &B);
 		}
 
 		// Access - for range based for.
@@ -128,11 +777,39 @@ template <typename AType, typename BType> class ManyToOneMapper
 		decltype(Mappings.begin()) begin(void) { return Mappings.begin(); }
 		decltype(Mappings.end()) end(void) { return Mappings.end(); }
 
+		// Calls Body(Pair &) for each B on the hardware threads, Grain Bs at a time.  Body may modify
+		// the objects pointed to by its own pair, as long as no other B's call touches the same A.  It
+		// must not change the pair itself (the B pointer or the vector of As) or call any mapper method
+		// that adds, removes, connects or disconnects.
+		template <typename BodyType> void ParallelForEach(BodyType const &Body, size_t Grain = 64)
+		{
+			ParallelFor(Mappings.size(), Grain, [this, &Body](size_t Start, size_t End)
+				{ for (size_t Index = Start; Index < End; Index++) Body(Mappings[Index]); });
+		}
+
 		Pair const &GetBMappings(BType const &Target)
 		{
 			assert(HasB(Target));
-			return *std::find_if(Mappings.begin(), Mappings.end(),
-				[&Target](Pair const &Element) { return Element.first == &Target; });
+			return Find(Target);
+		}
+
+		Frozen Freeze(void) const
+		{
+			Frozen Out;
+			Out.B.reserve(Mappings.size());
+			Out.Offsets.reserve(Mappings.size() + 1);
+			size_t Total = 0;
+			for (auto &CurrentMapping : Mappings) Total += CurrentMapping.second.size();
+			Out.A.reserve(Total);
+
+			Out.Offsets.push_back(0);
+			for (auto &CurrentMapping : Mappings)
+			{
+				Out.B.push_back(CurrentMapping.first);
+				Out.A.insert(Out.A.end(), CurrentMapping.second.begin(), CurrentMapping.second.end());
+				Out.Offsets.push_back(Out.A.size());
+			}
+			return Out;
 		}
 };
 
@@ -0,0 +1,283 @@
+#ifndef asyncpool_h
+#define asyncpool_h
+
+#include <map>
+#include <queue>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cassert>
+
+#include "accounting.h"
+
+/*
+Asynchronous pools construct their items on loader threads.
+
+Get returns a handle immediately.  Requests for a reference that is already loading share the
+same load.  Loads run highest priority first; a load whose handles have all been dropped before
+a loader reaches it is cancelled, and an item finished after its handles were dropped is
+discarded.  Continuations run on the loader thread once the item is ready, or immediately on the
+calling thread if it already is.  If the load fails the optional failure continuation runs
+instead, the same way; a cancelled load runs neither.
+*/
+
+template <typename ReferenceType, class ItemType> class AsyncPool;
+
+template <typename ReferenceType, class ItemType> class AsyncAccess
+{
+	public:
+		AsyncAccess(AsyncAccess<ReferenceType, ItemType> const &Coperand) : Owner(Coperand.Owner), Target(Coperand.Target)
+			{ Target->Bindings.fetch_add(1, std::memory_order_relaxed); }
+		~AsyncAccess(void) { Target->Bindings.fetch_sub(1, std::memory_order_acq_rel); }
+		AsyncAccess<ReferenceType, ItemType> &operator =(AsyncAccess<ReferenceType, ItemType> const &) = delete;
+
+		bool IsReady(void) const { return Target->Status.load(std::memory_order_acquire) == Owner->Ready; }
+		bool HasFailed(void) const { return Target->Status.load(std::memory_order_acquire) == Owner->Failed; }
+
+		// Blocks until the item is ready or has failed to load
+		void Wait(void) const { Owner->Wait(*Target); }
+
+		// Raises the priority of the load if it hasn't started yet
+		void Prioritize(int Priority) { Owner->Prioritize(*Target, Priority); }
+
+		void Then(std::function<void(ItemType &Item)> const &OnReady, std::function<void(void)> const &OnFailure = nullptr)
+			{ Owner->Then(*Target, OnReady, OnFailure); }
+
+		ItemType *operator ->(void) { assert(IsReady()); return Target->Item; }
+		ItemType &operator *(void) { assert(IsReady()); return *Target->Item; }
+
+	private:
+		friend class AsyncPool<ReferenceType, ItemType>;
+		typedef typename AsyncPool<ReferenceType, ItemType>::Load LoadType;
+
+		AsyncAccess(AsyncPool<ReferenceType, ItemType> *Owner, LoadType *Target) : Owner(Owner), Target(Target)
+			{ Target->Bindings.fetch_add(1, std::memory_order_relaxed); }
+
+		AsyncPool<ReferenceType, ItemType> *Owner;
+		LoadType *Target;
+};
+
+template <typename ReferenceType, class ItemType> class AsyncPool
+{
+	public:
+		AsyncPool(unsigned int LoaderCount = 0) : Stopping(false), Sequence(0)
+		{
+			if (LoaderCount == 0) LoaderCount = std::max(1u, std::thread::hardware_concurrency());
+			for (unsigned int Index = 0; Index < LoaderCount; Index++)
+				Loaders.push_back(std::thread([this](void) { LoaderMain(); }));
+		}
+
+		~AsyncPool(void)
+		{
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Stopping = true;
+			}
+			Waiting.notify_all();
+			for (auto &Loader : Loaders) Loader.join();
+
+			for (auto &CurrentLoad : Loads)
+			{
+				assert(CurrentLoad.second->Bindings.load() <= 0);
+				Release(*CurrentLoad.second);
+			}
+		}
+
+		AsyncAccess<ReferenceType, ItemType> Get(const ReferenceType &Reference, int Priority = 0)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			Load *&Found = Loads[Reference];
+			if (Found == nullptr)
+			{
+				Found = new Load(Reference, Priority);
+				Enqueue(*Found);
+			}
+			else if (Found->Status.load(std::memory_order_relaxed) == Cancelled)
+			{
+				Found->Status.store(Queued, std::memory_order_relaxed);
+				Found->Priority = Priority;
+				Enqueue(*Found);
+			}
+			else if ((Found->Status.load(std::memory_order_relaxed) == Queued) && (Priority > Found->Priority))
+			{
+				Found->Priority = Priority;
+				Enqueue(*Found);
+			}
+			return AsyncAccess<ReferenceType, ItemType>(this, Found);
+		}
+
+		// Deletes items and records that are no longer referenced.  Loads in progress are left alone.
+		void Prune(void)
+		{
+			std::vector<Load *> Releasable;
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				for (auto CurrentLoad = Loads.begin(); CurrentLoad != Loads.end(); )
+				{
+					Load &Candidate = *CurrentLoad->second;
+					if ((Candidate.Bindings.load(std::memory_order_acquire) <= 0) &&
+						(Candidate.Status.load(std::memory_order_relaxed) != Loading) &&
+						(Candidate.QueueEntries == 0))
+					{
+						Releasable.push_back(CurrentLoad->second);
+						CurrentLoad = Loads.erase(CurrentLoad);
+					}
+					else CurrentLoad++;
+				}
+			}
+			for (auto Releasee : Releasable) Release(*Releasee);
+		}
+
+	private:
+		friend class AsyncAccess<ReferenceType, ItemType>;
+		enum StatusType { Queued, Loading, Ready, Failed, Cancelled };
+
+		struct Continuation
+		{
+			std::function<void(ItemType &Item)> OnReady;
+			std::function<void(void)> OnFailure;
+		};
+
+		struct Load
+		{
+			Load(const ReferenceType &Reference, int Priority) :
+				Reference(Reference), Bindings(0), Status(Queued), Priority(Priority), QueueEntries(0), Item(nullptr)
+				{}
+
+			ReferenceType const Reference;
+			std::atomic<int> Bindings;
+			std::atomic<StatusType> Status; // Written under the pool mutex
+			int Priority;
+			unsigned int QueueEntries;
+			ItemType *Item;
+			std::vector<Continuation> Continuations;
+		};
+
+		struct QueueEntry
+		{
+			int Priority;
+			unsigned long Sequence;
+			Load *Target;
+			bool operator <(QueueEntry const &Other) const // Highest priority, then oldest, first
+				{ return (Priority < Other.Priority) || ((Priority == Other.Priority) && (Sequence > Other.Sequence)); }
+		};
+
+		static void Release(Load &Target)
+		{
+			if (Target.Item != nullptr) Accounting::Refund(Accounting::Tags::Pool(), sizeof(ItemType));
+			delete Target.Item;
+			delete &Target;
+		}
+
+		void Enqueue(Load &Target)
+		{
+			Queue.push(QueueEntry {Target.Priority, Sequence++, &Target});
+			Target.QueueEntries++;
+			Waiting.notify_one();
+		}
+
+		void Prioritize(Load &Target, int Priority)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			if ((Target.Status.load(std::memory_order_relaxed) != Queued) || (Priority <= Target.Priority)) return;
+			Target.Priority = Priority;
+			Enqueue(Target);
+		}
+
+		void Wait(Load &Target)
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			Finished.wait(Lock, [&Target](void)
+			{
+				StatusType Status = Target.Status.load(std::memory_order_relaxed);
+				return (Status == Ready) || (Status == Failed);
+			});
+		}
+
+		void Then(Load &Target, std::function<void(ItemType &Item)> const &OnReady, std::function<void(void)> const &OnFailure)
+		{
+			StatusType Status;
+			{
+				std::lock_guard<std::mutex> Lock(Mutex);
+				Status = Target.Status.load(std::memory_order_relaxed);
+				if ((Status != Ready) && (Status != Failed))
+				{
+					Target.Continuations.push_back(Continuation {OnReady, OnFailure});
+					return;
+				}
+			}
+			if (Status == Ready) OnReady(*Target.Item);
+			else if (OnFailure) OnFailure();
+		}
+
+		void LoaderMain(void)
+		{
+			std::unique_lock<std::mutex> Lock(Mutex);
+			while (true)
+			{
+				Waiting.wait(Lock, [this](void) { return Stopping || !Queue.empty(); });
+				if (Stopping) return;
+
+				Load &Target = *Queue.top().Target;
+				Queue.pop();
+				Target.QueueEntries--;
+
+				if (Target.Status.load(std::memory_order_relaxed) != Queued) continue; // Superseded entry
+				if (Target.Bindings.load(std::memory_order_acquire) <= 0)
+				{
+					Target.Status.store(Cancelled, std::memory_order_relaxed);
+					Target.Continuations.clear();
+					continue;
+				}
+				Target.Status.store(Loading, std::memory_order_relaxed);
+				Lock.unlock();
+
+				ItemType *Creation = nullptr;
+				try { Creation = new ItemType(Target.Reference); }
+				catch (...) {}
+
+				Lock.lock();
+				std::vector<Continuation> Continuations;
+				Continuations.swap(Target.Continuations);
+				if (Creation == nullptr) Target.Status.store(Failed, std::memory_order_release);
+				else if (Target.Bindings.load(std::memory_order_acquire) <= 0)
+					Target.Status.store(Cancelled, std::memory_order_relaxed);
+				else
+				{
+					Accounting::Charge(Accounting::Tags::Pool(), sizeof(ItemType));
+					Target.Item = Creation;
+					Target.Status.store(Ready, std::memory_order_release);
+					Creation = nullptr;
+					Target.Bindings.fetch_add(1, std::memory_order_relaxed); // Hold off pruning during continuations
+				}
+				StatusType const Status = Target.Status.load(std::memory_order_relaxed);
+				Lock.unlock();
+				Finished.notify_all();
+
+				delete Creation; // Discarded after cancellation
+				if (Status == Ready)
+				{
+					for (auto &Next : Continuations) Next.OnReady(*Target.Item);
+					Target.Bindings.fetch_sub(1, std::memory_order_acq_rel);
+				}
+				else if (Status == Failed)
+					for (auto &Next : Continuations) if (Next.OnFailure) Next.OnFailure();
+
+				Lock.lock();
+			}
+		}
+
+		std::mutex Mutex;
+		std::condition_variable Waiting, Finished;
+		bool Stopping;
+		unsigned long Sequence;
+		std::priority_queue<QueueEntry> Queue;
+		std::map<ReferenceType, Load *> Loads;
+		std::vector<std::thread> Loaders;
+};
+
+#endif
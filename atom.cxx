@@ -0,0 +1,120 @@
+#include "atom.h"
+
+#include <mutex>
+#include <vector>
+#include <cstring>
+
+#include "lifetime.h"
+
+// Interned texts live in sharded open-addressed tables.  Shards are picked by the top bits of the
+// hash and slots by the bottom bits, and each shard copies its texts into its own arena.
+namespace
+{
+	// Constant initialized, so atoms work during static initialization; the hash is FNV-1a of nothing
+	static Atom::Entry const EmptyEntry = {14695981039346656037ull, 0, ""};
+
+	unsigned int const ShardBits = 4, ShardCount = 1 << ShardBits;
+
+	struct alignas(64) Shard
+	{
+		Shard(void) : Texts(16384), Slots(256, nullptr), Count(0) {}
+
+		Atom::Entry const *Find(char const *Text, size_t Length, uint64_t Hash) const
+		{
+			size_t const Mask = Slots.size() - 1;
+			for (size_t Index = Hash & Mask; Slots[Index] != nullptr; Index = (Index + 1) & Mask)
+			{
+				Atom::Entry const *Candidate = Slots[Index];
+				if ((Candidate->Hash == Hash) && (Candidate->Length == Length) && (memcmp(Candidate->Text, Text, Length) == 0))
+					return Candidate;
+			}
+			return nullptr;
+		}
+
+		Atom::Entry const *Add(char const *Text, size_t Length, uint64_t Hash)
+		{
+			if ((Count + 1) * 10 > Slots.size() * 7) Grow();
+
+			char *Copy = static_cast<char *>(Texts.Allocate(Length + 1, 1));
+			memcpy(Copy, Text, Length);
+			Copy[Length] = 0;
+			Atom::Entry *Created = Texts.Make<Atom::Entry>();
+			Created->Hash = Hash;
+			Created->Length = Length;
+			Created->Text = Copy;
+
+			Insert(Created);
+			Count++;
+			return Created;
+		}
+
+		void Insert(Atom::Entry const *Insertee)
+		{
+			size_t const Mask = Slots.size() - 1;
+			size_t Index = Insertee->Hash & Mask;
+			while (Slots[Index] != nullptr) Index = (Index + 1) & Mask;
+			Slots[Index] = Insertee;
+		}
+
+		void Grow(void)
+		{
+			std::vector<Atom::Entry const *> Old(Slots.size() * 2, nullptr);
+			Old.swap(Slots);
+			for (auto Entry : Old) if (Entry != nullptr) Insert(Entry);
+		}
+
+		std::mutex Mutex;
+		Arena Texts;
+		std::vector<Atom::Entry const *> Slots;
+		size_t Count;
+	};
+
+	Shard &Select(uint64_t Hash)
+	{
+		static Shard Shards[ShardCount];
+		return Shards[Hash >> (64 - ShardBits)];
+	}
+}
+
+uint64_t Atom::HashText(char const *Text, size_t Length)
+{
+	uint64_t Hash = 14695981039346656037ull;
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		Hash ^= static_cast<unsigned char>(Text[Index]);
+		Hash *= 1099511628211ull;
+	}
+	return Hash;
+}
+
+Atom::Atom(void) : Target(&EmptyEntry) {}
+
+Atom::Atom(String const &Text) : Atom(Text.data(), Text.size()) {}
+
+Atom::Atom(char const *Text) : Atom(Text, strlen(Text)) {}
+
+Atom::Atom(char const *Text, size_t Length) : Target(&EmptyEntry)
+{
+	if (Length == 0) return;
+	uint64_t const Hash = HashText(Text, Length);
+	Shard &Owner = Select(Hash);
+	std::lock_guard<std::mutex> Lock(Owner.Mutex);
+	Target = Owner.Find(Text, Length, Hash);
+	if (Target == nullptr) Target = Owner.Add(Text, Length, Hash);
+}
+
+bool Atom::Find(String const &Text, Atom &Out)
+{
+	if (Text.empty())
+	{
+		Out = Atom();
+		return true;
+	}
+	uint64_t const Hash = HashText(Text.data(), Text.size());
+	Shard &Owner = Select(Hash);
+	std::lock_guard<std::mutex> Lock(Owner.Mutex);
+	Entry const *Found = Owner.Find(Text.data(), Text.size(), Hash);
+	if (Found == nullptr) return false;
+	Out = Atom(Found);
+	return true;
+}
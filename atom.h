@@ -0,0 +1,63 @@
+#ifndef atom_h
+#define atom_h
+
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "string.h"
+
+// Atoms are interned strings.  Each distinct text is stored once, for the life of the program, in a
+// shared table, and an Atom is just a pointer to it, so copying, comparing and hashing are O(1).
+// Interning costs a hash and a lookup, so intern identifiers once and keep the Atoms around.
+// Atoms may be created and used from any thread.
+class Atom
+{
+	public:
+		struct Entry
+		{
+			uint64_t Hash;
+			size_t Length;
+			char const *Text; // Null terminated
+		};
+
+		Atom(void); // The empty string
+		explicit Atom(String const &Text);
+		explicit Atom(char const *Text);
+		Atom(char const *Text, size_t Length);
+
+		// Only finds existing atoms; returns false rather than interning
+		static bool Find(String const &Text, Atom &Out);
+
+		bool operator ==(Atom const &Other) const { return Target == Other.Target; }
+		bool operator !=(Atom const &Other) const { return Target != Other.Target; }
+		// Arbitrary but consistent within a run; not alphabetical
+		bool operator <(Atom const &Other) const { return Target < Other.Target; }
+
+		bool IsEmpty(void) const { return Target->Length == 0; }
+		uint64_t GetHash(void) const { return Target->Hash; }
+		size_t GetLength(void) const { return Target->Length; }
+		char const *GetText(void) const { return Target->Text; }
+		String AsString(void) const { return String(Target->Text, Target->Length); }
+#if __cplusplus >= 201703L
+		std::string_view AsStringView(void) const { return std::string_view(Target->Text, Target->Length); }
+		explicit Atom(std::string_view Text) : Atom(Text.data(), Text.size()) {}
+#endif
+
+		static uint64_t HashText(char const *Text, size_t Length); // FNV-1a
+
+	private:
+		Atom(Entry const *Target) : Target(Target) {}
+		Entry const *Target;
+};
+
+namespace std
+{
+	template <> struct hash<Atom>
+		{ size_t operator()(Atom const &Hashee) const { return static_cast<size_t>(Hashee.GetHash()); } };
+}
+
+#endif
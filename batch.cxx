@@ -0,0 +1,341 @@
+#include "batch.h"
+
+#include "cpu.h"
+#include "vector.h"
+#include "color.h"
+
+#ifdef WINDOWS
+#include <stdlib.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BATCH_X86
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(Vector) == 3 * sizeof(float), "Batch kernels treat vector arrays as float arrays.");
+static_assert(sizeof(Color) == 4 * sizeof(float), "Batch kernels treat color arrays as float arrays.");
+
+namespace Batch
+{
+
+// ========================================================================
+// Scalar, also finishing the tails of the wider versions
+
+static void MultiplyAddScalar(float *Out, float const *Addend, float Scale, size_t Count)
+	{ for (size_t Index = 0; Index < Count; Index++) Out[Index] += Addend[Index] * Scale; }
+
+static void ToBytesScalar(float const *Channels, size_t Count, uint8_t *Out)
+{
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		// Same operand order as minps and maxps, so NaN ends up as 1
+		float Channel = Channels[Index];
+		Channel = (Channel < 1.0f) ? Channel : 1.0f;
+		Channel = (Channel > 0.0f) ? Channel : 0.0f;
+		Out[Index] = static_cast<uint8_t>(Channel * 255.0f + 0.5f);
+	}
+}
+
+static void Swap16Scalar(uint16_t *Values, size_t Count)
+{
+	for (size_t Index = 0; Index < Count; Index++)
+		Values[Index] = static_cast<uint16_t>((Values[Index] << 8) | (Values[Index] >> 8));
+}
+
+static void Swap32Scalar(uint32_t *Values, size_t Count)
+{
+	for (size_t Index = 0; Index < Count; Index++)
+#ifdef WINDOWS
+		Values[Index] = _byteswap_ulong(Values[Index]);
+#else
+		Values[Index] = __builtin_bswap32(Values[Index]);
+#endif
+}
+
+static void Swap64Scalar(uint64_t *Values, size_t Count)
+{
+	for (size_t Index = 0; Index < Count; Index++)
+#ifdef WINDOWS
+		Values[Index] = _byteswap_uint64(Values[Index]);
+#else
+		Values[Index] = __builtin_bswap64(Values[Index]);
+#endif
+}
+
+static char const HexDigits[] = "0123456789abcdef";
+
+static void HexScalar(uint8_t const *Data, size_t Length, char *Out)
+{
+	for (size_t Index = 0; Index < Length; Index++)
+	{
+		Out[Index * 2] = HexDigits[Data[Index] >> 4];
+		Out[Index * 2 + 1] = HexDigits[Data[Index] & 0xF];
+	}
+}
+
+#ifdef BATCH_X86
+
+// ========================================================================
+// SSE2
+
+__attribute__((target("sse2"))) static void MultiplyAddSSE2(float *Out, float const *Addend, float Scale, size_t Count)
+{
+	__m128 const Scales = _mm_set1_ps(Scale);
+	size_t Index = 0;
+	for (; Index + 4 <= Count; Index += 4)
+		_mm_storeu_ps(Out + Index, _mm_add_ps(_mm_loadu_ps(Out + Index), _mm_mul_ps(_mm_loadu_ps(Addend + Index), Scales)));
+	MultiplyAddScalar(Out + Index, Addend + Index, Scale, Count - Index);
+}
+
+__attribute__((target("sse2"))) static inline __m128i ToIntegersSSE2(float const *Channels)
+{
+	__m128 Channel = _mm_loadu_ps(Channels);
+	Channel = _mm_max_ps(_mm_min_ps(Channel, _mm_set1_ps(1.0f)), _mm_setzero_ps());
+	return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Channel, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+}
+
+__attribute__((target("sse2"))) static void ToBytesSSE2(float const *Channels, size_t Count, uint8_t *Out)
+{
+	size_t Index = 0;
+	for (; Index + 16 <= Count; Index += 16)
+	{
+		__m128i const Low = _mm_packs_epi32(ToIntegersSSE2(Channels + Index), ToIntegersSSE2(Channels + Index + 4));
+		__m128i const High = _mm_packs_epi32(ToIntegersSSE2(Channels + Index + 8), ToIntegersSSE2(Channels + Index + 12));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Index), _mm_packus_epi16(Low, High));
+	}
+	ToBytesScalar(Channels + Index, Count - Index, Out + Index);
+}
+
+// ========================================================================
+// SSE4.2 level; the byte shuffles only need SSSE3
+
+__attribute__((target("sse4.2"))) static void SwapBytesSSE42(uint8_t *Data, size_t Length, __m128i const &Order)
+{
+	size_t Index = 0;
+	for (; Index + 16 <= Length; Index += 16)
+	{
+		__m128i *Block = reinterpret_cast<__m128i *>(Data + Index);
+		_mm_storeu_si128(Block, _mm_shuffle_epi8(_mm_loadu_si128(Block), Order));
+	}
+}
+
+__attribute__((target("sse4.2"))) static void Swap16SSE42(uint16_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(7);
+	SwapBytesSSE42(reinterpret_cast<uint8_t *>(Values), Vectorized * 2, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+	Swap16Scalar(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("sse4.2"))) static void Swap32SSE42(uint32_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(3);
+	SwapBytesSSE42(reinterpret_cast<uint8_t *>(Values), Vectorized * 4, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+	Swap32Scalar(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("sse4.2"))) static void Swap64SSE42(uint64_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(1);
+	SwapBytesSSE42(reinterpret_cast<uint8_t *>(Values), Vectorized * 8, _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+	Swap64Scalar(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("sse4.2"))) static void HexSSE42(uint8_t const *Data, size_t Length, char *Out)
+{
+	__m128i const Digits = _mm_loadu_si128(reinterpret_cast<__m128i const *>(HexDigits));
+	__m128i const Nibble = _mm_set1_epi8(0xF);
+	size_t Index = 0;
+	for (; Index + 16 <= Length; Index += 16)
+	{
+		__m128i const Bytes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Data + Index));
+		__m128i const High = _mm_shuffle_epi8(Digits, _mm_and_si128(_mm_srli_epi16(Bytes, 4), Nibble));
+		__m128i const Low = _mm_shuffle_epi8(Digits, _mm_and_si128(Bytes, Nibble));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Index * 2), _mm_unpacklo_epi8(High, Low));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Index * 2 + 16), _mm_unpackhi_epi8(High, Low));
+	}
+	HexScalar(Data + Index, Length - Index, Out + Index * 2);
+}
+
+// ========================================================================
+// AVX2
+
+__attribute__((target("avx2"))) static void MultiplyAddAVX2(float *Out, float const *Addend, float Scale, size_t Count)
+{
+	__m256 const Scales = _mm256_set1_ps(Scale);
+	size_t Index = 0;
+	for (; Index + 8 <= Count; Index += 8)
+		_mm256_storeu_ps(Out + Index, _mm256_add_ps(_mm256_loadu_ps(Out + Index), _mm256_mul_ps(_mm256_loadu_ps(Addend + Index), Scales)));
+	MultiplyAddScalar(Out + Index, Addend + Index, Scale, Count - Index);
+}
+
+__attribute__((target("avx2"))) static inline __m256i ToIntegersAVX2(float const *Channels)
+{
+	__m256 Channel = _mm256_loadu_ps(Channels);
+	Channel = _mm256_max_ps(_mm256_min_ps(Channel, _mm256_set1_ps(1.0f)), _mm256_setzero_ps());
+	return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(Channel, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+}
+
+__attribute__((target("avx2"))) static void ToBytesAVX2(float const *Channels, size_t Count, uint8_t *Out)
+{
+	// The packs work within 128 bit lanes, leaving 4 byte groups out of order
+	__m256i const Order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t Index = 0;
+	for (; Index + 32 <= Count; Index += 32)
+	{
+		__m256i const Low = _mm256_packs_epi32(ToIntegersAVX2(Channels + Index), ToIntegersAVX2(Channels + Index + 8));
+		__m256i const High = _mm256_packs_epi32(ToIntegersAVX2(Channels + Index + 16), ToIntegersAVX2(Channels + Index + 24));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(Out + Index), _mm256_permutevar8x32_epi32(_mm256_packus_epi16(Low, High), Order));
+	}
+	ToBytesSSE2(Channels + Index, Count - Index, Out + Index);
+}
+
+__attribute__((target("avx2"))) static void SwapBytesAVX2(uint8_t *Data, size_t Length, __m256i const &Order)
+{
+	size_t Index = 0;
+	for (; Index + 32 <= Length; Index += 32)
+	{
+		__m256i *Block = reinterpret_cast<__m256i *>(Data + Index);
+		_mm256_storeu_si256(Block, _mm256_shuffle_epi8(_mm256_loadu_si256(Block), Order));
+	}
+}
+
+__attribute__((target("avx2"))) static void Swap16AVX2(uint16_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(15);
+	SwapBytesAVX2(reinterpret_cast<uint8_t *>(Values), Vectorized * 2, _mm256_setr_epi8(
+		1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+	Swap16SSE42(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("avx2"))) static void Swap32AVX2(uint32_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(7);
+	SwapBytesAVX2(reinterpret_cast<uint8_t *>(Values), Vectorized * 4, _mm256_setr_epi8(
+		3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+	Swap32SSE42(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("avx2"))) static void Swap64AVX2(uint64_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(3);
+	SwapBytesAVX2(reinterpret_cast<uint8_t *>(Values), Vectorized * 8, _mm256_setr_epi8(
+		7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+	Swap64SSE42(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("avx2"))) static void HexAVX2(uint8_t const *Data, size_t Length, char *Out)
+{
+	__m256i const Digits = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const *>(HexDigits)));
+	__m256i const Nibble = _mm256_set1_epi8(0xF);
+	size_t Index = 0;
+	for (; Index + 32 <= Length; Index += 32)
+	{
+		__m256i const Bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(Data + Index));
+		__m256i const High = _mm256_shuffle_epi8(Digits, _mm256_and_si256(_mm256_srli_epi16(Bytes, 4), Nibble));
+		__m256i const Low = _mm256_shuffle_epi8(Digits, _mm256_and_si256(Bytes, Nibble));
+		// The unpacks work within lanes: First holds bytes 0-7 and 16-23, Second 8-15 and 24-31
+		__m256i const First = _mm256_unpacklo_epi8(High, Low), Second = _mm256_unpackhi_epi8(High, Low);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(Out + Index * 2), _mm256_permute2x128_si256(First, Second, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(Out + Index * 2 + 32), _mm256_permute2x128_si256(First, Second, 0x31));
+	}
+	HexSSE42(Data + Index, Length - Index, Out + Index * 2);
+}
+
+// ========================================================================
+// AVX-512
+
+__attribute__((target("avx512f"))) static void MultiplyAddAVX512(float *Out, float const *Addend, float Scale, size_t Count)
+{
+	__m512 const Scales = _mm512_set1_ps(Scale);
+	size_t Index = 0;
+	for (; Index + 16 <= Count; Index += 16)
+		_mm512_storeu_ps(Out + Index, _mm512_add_ps(_mm512_loadu_ps(Out + Index), _mm512_mul_ps(_mm512_loadu_ps(Addend + Index), Scales)));
+	MultiplyAddAVX2(Out + Index, Addend + Index, Scale, Count - Index);
+}
+
+__attribute__((target("avx512bw"))) static void SwapBytesAVX512(uint8_t *Data, size_t Length, __m512i const &Order)
+{
+	size_t Index = 0;
+	for (; Index + 64 <= Length; Index += 64)
+		_mm512_storeu_si512(Data + Index, _mm512_shuffle_epi8(_mm512_loadu_si512(Data + Index), Order));
+}
+
+// The same 16 byte shuffle in each lane, given as its low and high 8 bytes
+__attribute__((target("avx512f"))) static inline __m512i RepeatLanes(uint64_t Low, uint64_t High)
+	{ return _mm512_set_epi64(High, Low, High, Low, High, Low, High, Low); }
+
+__attribute__((target("avx512bw"))) static void Swap16AVX512(uint16_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(31);
+	SwapBytesAVX512(reinterpret_cast<uint8_t *>(Values), Vectorized * 2,
+		RepeatLanes(0x0607040502030001ull, 0x0E0F0C0D0A0B0809ull));
+	Swap16AVX2(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("avx512bw"))) static void Swap32AVX512(uint32_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(15);
+	SwapBytesAVX512(reinterpret_cast<uint8_t *>(Values), Vectorized * 4,
+		RepeatLanes(0x0405060700010203ull, 0x0C0D0E0F08090A0Bull));
+	Swap32AVX2(Values + Vectorized, Count - Vectorized);
+}
+
+__attribute__((target("avx512bw"))) static void Swap64AVX512(uint64_t *Values, size_t Count)
+{
+	size_t const Vectorized = Count & ~size_t(7);
+	SwapBytesAVX512(reinterpret_cast<uint8_t *>(Values), Vectorized * 8,
+		RepeatLanes(0x0001020304050607ull, 0x08090A0B0C0D0E0Full));
+	Swap64AVX2(Values + Vectorized, Count - Vectorized);
+}
+
+#endif
+
+// ========================================================================
+// Dispatch
+
+struct Kernels
+{
+	void (*MultiplyAdd)(float *Out, float const *Addend, float Scale, size_t Count);
+	void (*ToBytes)(float const *Channels, size_t Count, uint8_t *Out);
+	void (*Swap16)(uint16_t *Values, size_t Count);
+	void (*Swap32)(uint32_t *Values, size_t Count);
+	void (*Swap64)(uint64_t *Values, size_t Count);
+	void (*Hex)(uint8_t const *Data, size_t Length, char *Out);
+};
+
+// Indexed by CPU::Level; levels without a kernel of their own use the next best
+static Kernels const Table[CPU::LevelCount] =
+{
+	{MultiplyAddScalar, ToBytesScalar, Swap16Scalar, Swap32Scalar, Swap64Scalar, HexScalar},
+#ifdef BATCH_X86
+	{MultiplyAddSSE2, ToBytesSSE2, Swap16Scalar, Swap32Scalar, Swap64Scalar, HexScalar},
+	{MultiplyAddSSE2, ToBytesSSE2, Swap16SSE42, Swap32SSE42, Swap64SSE42, HexSSE42},
+	{MultiplyAddAVX2, ToBytesAVX2, Swap16AVX2, Swap32AVX2, Swap64AVX2, HexAVX2},
+	{MultiplyAddAVX512, ToBytesAVX2, Swap16AVX512, Swap32AVX512, Swap64AVX512, HexAVX2}
+#else
+	{MultiplyAddScalar, ToBytesScalar, Swap16Scalar, Swap32Scalar, Swap64Scalar, HexScalar},
+	{MultiplyAddScalar, ToBytesScalar, Swap16Scalar, Swap32Scalar, Swap64Scalar, HexScalar},
+	{MultiplyAddScalar, ToBytesScalar, Swap16Scalar, Swap32Scalar, Swap64Scalar, HexScalar},
+	{MultiplyAddScalar, ToBytesScalar, Swap16Scalar, Swap32Scalar, Swap64Scalar, HexScalar}
+#endif
+};
+
+static inline Kernels const &Selected(void) { return Table[static_cast<unsigned int>(CPU::GetLevel())]; }
+
+void MultiplyAdd(Vector *Positions, Vector const *Velocities, float Scale, size_t Count)
+	{ Selected().MultiplyAdd(reinterpret_cast<float *>(Positions), reinterpret_cast<float const *>(Velocities), Scale, Count * 3); }
+
+void ToBytes(Color const *Colors, size_t Count, uint8_t *Out)
+	{ Selected().ToBytes(reinterpret_cast<float const *>(Colors), Count * 4, Out); }
+
+void Swap(uint16_t *Values, size_t Count) { Selected().Swap16(Values, Count); }
+
+void Swap(uint32_t *Values, size_t Count) { Selected().Swap32(Values, Count); }
+
+void Swap(uint64_t *Values, size_t Count) { Selected().Swap64(Values, Count); }
+
+void Hex(void const *Data, size_t Length, char *Out)
+	{ Selected().Hex(static_cast<uint8_t const *>(Data), Length, Out); }
+
+}
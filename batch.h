@@ -0,0 +1,34 @@
+#ifndef batch_h
+#define batch_h
+
+#include <cstdint>
+#include <cstddef>
+
+class Vector;
+class Color;
+
+/*
+Kernels over arrays, dispatched to the best implementation for CPU::GetLevel.  Every
+implementation gives the same results as the scalar one.
+*/
+
+namespace Batch
+{
+
+// Positions[Index] += Velocities[Index] * Scale
+void MultiplyAdd(Vector *Positions, Vector const *Velocities, float Scale, size_t Count);
+
+// Clamps to [0, 1] and rounds to 8 bit RGBA, 4 bytes per color.  NaN channels become 255.
+void ToBytes(Color const *Colors, size_t Count, uint8_t *Out);
+
+// Reverses the byte order of each value in place
+void Swap(uint16_t *Values, size_t Count);
+void Swap(uint32_t *Values, size_t Count);
+void Swap(uint64_t *Values, size_t Count);
+
+// Writes 2 * Length lowercase hex digits, high nibble first.  Out isn't null terminated.
+void Hex(void const *Data, size_t Length, char *Out);
+
+}
+
+#endif
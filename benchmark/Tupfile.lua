@@ -0,0 +1,11 @@
+DoOnce 'info.lua'
+
+-- Built against the library objects; run by hand, not as part of the normal build.
+-- benchmark [--filter TEXT] [--samples N] [--warmup N] [--min-time MS] [--json FILE|-]
+Define.Executable
+{
+	Name = 'benchmark',
+	Sources = Item '*.cxx',
+	Objects = GeneralObjects,
+	LinkFlags = '-pthread'
+}
@@ -0,0 +1,36 @@
+#include "benchmark.h"
+
+#include "../batch.h"
+#include "../vector.h"
+#include "../color.h"
+
+// Batch kernels at the dispatched level; set RENGENERAL_CPU to compare levels
+
+static size_t const BatchSize = 4096;
+
+static Benchmark::Case BatchMultiplyAdd("batch/multiplyadd-4k", [](size_t Count)
+{
+	static std::vector<Vector> Positions(BatchSize), Velocities(BatchSize, Vector(0.5f, 0.25f, 0.125f));
+	for (size_t Index = 0; Index < Count; Index++) Batch::MultiplyAdd(Positions.data(), Velocities.data(), 0.001f, BatchSize);
+	Benchmark::Keep(Positions[0]);
+});
+
+static Benchmark::Case BatchToBytes("batch/tobytes-4k", [](size_t Count)
+{
+	static std::vector<Color> const Colors(BatchSize, Color(0.25f, 0.5f, 0.75f, 1.0f));
+	static std::vector<uint8_t> Out(BatchSize * 4);
+	for (size_t Index = 0; Index < Count; Index++) { Batch::ToBytes(Colors.data(), BatchSize, Out.data()); Benchmark::Keep(Out[0]); }
+});
+
+static Benchmark::Case BatchSwap32("batch/swap32-4k", [](size_t Count)
+{
+	static std::vector<uint32_t> Values(BatchSize, 0x01020304);
+	for (size_t Index = 0; Index < Count; Index++) { Batch::Swap(Values.data(), BatchSize); Benchmark::Keep(Values[0]); }
+});
+
+static Benchmark::Case BatchHex("batch/hex-4k", [](size_t Count)
+{
+	static std::vector<uint8_t> const Data(BatchSize, 0xA5);
+	static std::vector<char> Out(BatchSize * 2);
+	for (size_t Index = 0; Index < Count; Index++) { Batch::Hex(Data.data(), BatchSize, Out.data()); Benchmark::Keep(Out[0]); }
+});
@@ -0,0 +1,191 @@
+#include "benchmark.h"
+
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+
+namespace Benchmark
+{
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+struct Registered
+{
+	String Name;
+	BodyType Body;
+};
+
+static std::vector<Registered> &Registry(void)
+{
+	// A function static, since cases register from other files' static initializers
+	static std::vector<Registered> Cases;
+	return Cases;
+}
+
+Case::Case(char const *Name, BodyType const &Body)
+	{ Registry().push_back(Registered {Name, Body}); }
+
+Settings::Settings(void) : WarmupSamples(3), Samples(30), MinimumSampleSeconds(0.002) {}
+
+static double Time(BodyType const &Body, size_t Count)
+{
+	BenchmarkClock::time_point const Start = BenchmarkClock::now();
+	Body(Count);
+	return std::chrono::duration<double>(BenchmarkClock::now() - Start).count();
+}
+
+static double Percentile(std::vector<double> const &Sorted, double Fraction)
+{
+	// Linear interpolation between the closest ranks
+	double const Position = Fraction * (Sorted.size() - 1);
+	size_t const Below = static_cast<size_t>(Position);
+	if (Below + 1 >= Sorted.size()) return Sorted.back();
+	return Sorted[Below] + (Sorted[Below + 1] - Sorted[Below]) * (Position - Below);
+}
+
+static Statistics Measure(Registered const &Measured, Settings const &Configuration)
+{
+	// Grow the batch until one sample is long enough for the clock's resolution not to matter
+	size_t Count = 1;
+	while (true)
+	{
+		double const Elapsed = Time(Measured.Body, Count);
+		if (Elapsed >= Configuration.MinimumSampleSeconds) break;
+		double const Growth = (Elapsed <= 0.0) ? 10.0 : std::min(10.0, std::max(1.5, Configuration.MinimumSampleSeconds * 1.2 / Elapsed));
+		Count = static_cast<size_t>(std::ceil(Count * Growth));
+	}
+
+	for (unsigned int Sample = 0; Sample < Configuration.WarmupSamples; Sample++) Time(Measured.Body, Count);
+
+	std::vector<double> Samples;
+	Samples.reserve(Configuration.Samples);
+	Statistics Out;
+	for (unsigned int Sample = 0; Sample < std::max(1u, Configuration.Samples); Sample++)
+	{
+		Counters::Scope Counted(Out.Counts);
+		Samples.push_back(Time(Measured.Body, Count) * 1e9 / Count);
+	}
+	std::sort(Samples.begin(), Samples.end());
+
+	for (unsigned int Index = 0; Index < Counters::EventCount; Index++)
+		Out.PerOperation[Index] = static_cast<double>(Out.Counts.Values[Index]) / (static_cast<double>(Count) * Samples.size());
+	Out.Name = Measured.Name;
+	Out.CountPerSample = Count;
+	Out.Samples = static_cast<unsigned int>(Samples.size());
+	double Sum = 0.0;
+	for (double Sample : Samples) Sum += Sample;
+	Out.Mean = Sum / Samples.size();
+	double SquaredDifferences = 0.0;
+	for (double Sample : Samples) SquaredDifferences += (Sample - Out.Mean) * (Sample - Out.Mean);
+	Out.Deviation = (Samples.size() > 1) ? std::sqrt(SquaredDifferences / (Samples.size() - 1)) : 0.0;
+	Out.Minimum = Samples.front();
+	Out.Median = Percentile(Samples, 0.5);
+	Out.P90 = Percentile(Samples, 0.9);
+	Out.P99 = Percentile(Samples, 0.99);
+	Out.Maximum = Samples.back();
+	return Out;
+}
+
+std::vector<Statistics> Run(Settings const &Configuration)
+{
+	std::vector<Registered> Cases = Registry();
+	std::sort(Cases.begin(), Cases.end(), [](Registered const &First, Registered const &Second) { return First.Name < Second.Name; });
+	std::vector<Statistics> Out;
+	for (auto &Current : Cases)
+	{
+		if (!Configuration.Filter.empty() && (Current.Name.find(Configuration.Filter) == String::npos)) continue;
+		Out.push_back(Measure(Current, Configuration));
+	}
+	return Out;
+}
+
+}
+
+static void WriteText(std::ostream &Out, std::vector<Benchmark::Statistics> const &Results)
+{
+	// Counter columns only when some case has them
+	Counters::Reading Counted;
+	for (auto &Result : Results) Counted.Valid |= Result.Counts.Valid;
+
+	Out << std::left << std::setw(36) << "case" << std::right <<
+		std::setw(12) << "median ns" << std::setw(12) << "p90 ns" << std::setw(12) << "p99 ns" <<
+		std::setw(12) << "min ns" << std::setw(10) << "cv %";
+	for (unsigned int Index = 0; Index < Counters::EventCount; Index++)
+		if (Counted.Has(static_cast<Counters::Event>(Index))) Out << std::setw(16) << Counters::GetName(static_cast<Counters::Event>(Index));
+	Out << "\n" << std::fixed << std::setprecision(2);
+	for (auto &Result : Results)
+	{
+		Out << std::left << std::setw(36) << Result.Name << std::right <<
+			std::setw(12) << Result.Median << std::setw(12) << Result.P90 << std::setw(12) << Result.P99 <<
+			std::setw(12) << Result.Minimum << std::setw(10) << (Result.Mean > 0.0 ? Result.Deviation * 100.0 / Result.Mean : 0.0);
+		for (unsigned int Index = 0; Index < Counters::EventCount; Index++)
+		{
+			if (!Counted.Has(static_cast<Counters::Event>(Index))) continue;
+			if (Result.Counts.Has(static_cast<Counters::Event>(Index))) Out << std::setw(16) << Result.PerOperation[Index];
+			else Out << std::setw(16) << "-";
+		}
+		Out << "\n";
+	}
+}
+
+static void WriteJSON(std::ostream &Out, std::vector<Benchmark::Statistics> const &Results)
+{
+	// Names are plain ASCII identifiers, so nothing needs escaping
+	// Counter fields are per operation and only present where counters were available
+	Out << std::setprecision(6) << "{\n\t\"unit\": \"ns/op\",\n\t\"results\":\n\t[";
+	bool First = true;
+	for (auto &Result : Results)
+	{
+		Out << (First ? "\n" : ",\n") << "\t\t{\"name\": \"" << Result.Name << "\", " <<
+			"\"count\": " << Result.CountPerSample << ", \"samples\": " << Result.Samples << ", " <<
+			"\"min\": " << Result.Minimum << ", \"median\": " << Result.Median << ", " <<
+			"\"mean\": " << Result.Mean << ", \"stddev\": " << Result.Deviation << ", " <<
+			"\"p90\": " << Result.P90 << ", \"p99\": " << Result.P99 << ", \"max\": " << Result.Maximum;
+		for (unsigned int Index = 0; Index < Counters::EventCount; Index++)
+			if (Result.Counts.Has(static_cast<Counters::Event>(Index)))
+				Out << ", \"" << Counters::GetName(static_cast<Counters::Event>(Index)) << "\": " << Result.PerOperation[Index];
+		Out << "}";
+		First = false;
+	}
+	Out << "\n\t]\n}\n";
+}
+
+int main(int ArgumentCount, char **Arguments)
+{
+	Benchmark::Settings Configuration;
+	String JSONLocation;
+	for (int Index = 1; Index < ArgumentCount; Index++)
+	{
+		String const Argument = Arguments[Index];
+		bool const HasValue = Index + 1 < ArgumentCount;
+		if ((Argument == "--filter") && HasValue) Configuration.Filter = Arguments[++Index];
+		else if ((Argument == "--samples") && HasValue) Configuration.Samples = std::atoi(Arguments[++Index]);
+		else if ((Argument == "--warmup") && HasValue) Configuration.WarmupSamples = std::atoi(Arguments[++Index]);
+		else if ((Argument == "--min-time") && HasValue) Configuration.MinimumSampleSeconds = std::atof(Arguments[++Index]) / 1000.0;
+		else if ((Argument == "--json") && HasValue) JSONLocation = Arguments[++Index];
+		else
+		{
+			std::cerr << "Usage: " << Arguments[0] << " [--filter TEXT] [--samples N] [--warmup N] [--min-time MS] [--json FILE|-]\n";
+			return 1;
+		}
+	}
+
+	std::vector<Benchmark::Statistics> const Results = Benchmark::Run(Configuration);
+	if (JSONLocation == "-") WriteJSON(std::cout, Results);
+	else
+	{
+		WriteText(std::cout, Results);
+		if (!JSONLocation.empty())
+		{
+			std::ofstream JSONFile(JSONLocation.c_str());
+			if (!JSONFile) { std::cerr << "Couldn't open " << JSONLocation << "\n"; return 1; }
+			WriteJSON(JSONFile, Results);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef benchmark_h
+#define benchmark_h
+
+#include <functional>
+#include <vector>
+#include <cstddef>
+
+#include "../string.h"
+#include "../counters.h"
+
+/*
+A small microbenchmark harness.
+
+	static Benchmark::Case VectorAdd("vector/add", [](size_t Count)
+	{
+		Vector Sum;
+		for (size_t Index = 0; Index < Count; Index++) Sum += Vector(1, 2, 3);
+		Benchmark::Keep(Sum);
+	});
+
+A case body runs its operation Count times.  The harness picks Count so each sample lasts at least
+the minimum sample time, runs warmup samples, then reports per-operation nanoseconds over the
+timed samples.  Where hardware counters are available, their counts per operation on the calling
+thread are reported too.  Setup belongs in function statics or outside the loop; anything in the body is
+timed.
+*/
+
+namespace Benchmark
+{
+
+typedef std::function<void(size_t Count)> BodyType;
+
+// Registers a case at static initialization
+struct Case
+{
+	Case(char const *Name, BodyType const &Body);
+};
+
+// Stops the optimizer from discarding a result
+template <typename ValueType> inline void Keep(ValueType const &Value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "m"(Value) : "memory");
+#else
+	static void const volatile *volatile Sink;
+	Sink = &Value;
+#endif
+}
+
+struct Settings
+{
+	Settings(void);
+	String Filter; // Substring of the names to run; empty runs everything
+	unsigned int WarmupSamples, Samples;
+	double MinimumSampleSeconds;
+};
+
+struct Statistics
+{
+	String Name;
+	size_t CountPerSample;
+	unsigned int Samples;
+	double Minimum, Median, Mean, Deviation, P90, P99, Maximum; // Nanoseconds per operation
+	double PerOperation[Counters::EventCount]; // Hardware counts over the timed samples, where Counts.Has them
+	Counters::Reading Counts;
+};
+
+std::vector<Statistics> Run(Settings const &Configuration);
+
+}
+
+#endif
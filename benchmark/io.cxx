@@ -0,0 +1,149 @@
+#include "benchmark.h"
+
+#include "../inputoutput.h"
+#include "../filesystem.h"
+#include "../annals.h"
+
+#include <chrono>
+#ifdef WINDOWS
+#include <direct.h>
+#else
+#include <unistd.h>
+#endif
+
+// Stream formatting, file reads, directory walks and logging
+
+namespace
+{
+
+// A scratch directory tree, removed at exit
+class Scratch
+{
+	public:
+		Scratch(void) : Root(LocateTemporaryDirectory())
+		{
+			Root.Enter("rengeneral-benchmark-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+			Root.Create(false);
+			Directories.push_back(Root);
+		}
+
+		~Scratch(void)
+		{
+			for (auto File = Files.rbegin(); File != Files.rend(); File++) File->Delete();
+			for (auto Directory = Directories.rbegin(); Directory != Directories.rend(); Directory++)
+			{
+#ifdef WINDOWS
+				_wrmdir(reinterpret_cast<wchar_t const *>(AsNativeString(Directory->AsAbsoluteString()).c_str()));
+#else
+				rmdir(Directory->AsAbsoluteString().c_str());
+#endif
+			}
+		}
+
+		static Scratch &Get(void)
+		{
+			static Scratch Instance;
+			return Instance;
+		}
+
+		DirectoryPath MakeDirectory(String const &Name) { return MakeDirectory(Root, Name); }
+
+		DirectoryPath MakeDirectory(DirectoryPath const &Parent, String const &Name)
+		{
+			DirectoryPath Out = Parent;
+			Out.Enter(Name);
+			Out.Create(false);
+			Directories.push_back(Out);
+			return Out;
+		}
+
+		FilePath MakeFile(DirectoryPath const &Directory, String const &Name, String const &Contents)
+		{
+			FilePath Out = Directory.Select(Name);
+			{
+				FileOutput Writer = Out.Write(false, true);
+				Writer << Contents;
+			}
+			Files.push_back(Out);
+			return Out;
+		}
+
+	private:
+		DirectoryPath Root;
+		std::vector<DirectoryPath> Directories;
+		std::vector<FilePath> Files;
+};
+
+}
+
+static Benchmark::Case MemoryStreamFormat("memorystream/format", [](size_t Count)
+{
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		MemoryStream Out;
+		Out << static_cast<int>(Index) << ' ' << 3.25f << ' ' << String("label") << '\n';
+		String Result = Out;
+		Benchmark::Keep(Result);
+	}
+});
+
+static Benchmark::Case FileInputReadLine("fileinput/readline", [](size_t Count)
+{
+	static FilePath const Source = [](void)
+	{
+		Scratch &Files = Scratch::Get();
+		String Contents;
+		for (unsigned int Line = 0; Line < 4096; Line++)
+			Contents += "line " + std::to_string(Line) + " of some moderately long text in a configuration file\n";
+		return Files.MakeFile(Files.MakeDirectory("read"), "lines.txt", Contents);
+	}();
+	FileInput Reader = Source.Read();
+	String Line;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		Reader >> Line;
+		if (!Reader) Reader = Source.Read();
+		Benchmark::Keep(Line);
+	}
+});
+
+static Benchmark::Case DirectoryWalk("directorypath/walk", [](size_t Count)
+{
+	// 4 directories of 4 subdirectories, each holding 8 files, per operation
+	static DirectoryPath const Tree = [](void)
+	{
+		Scratch &Files = Scratch::Get();
+		DirectoryPath Out = Files.MakeDirectory("walk");
+		for (unsigned int Outer = 0; Outer < 4; Outer++)
+		{
+			DirectoryPath const Middle = Files.MakeDirectory(Out, "d" + std::to_string(Outer));
+			for (unsigned int Inner = 0; Inner < 4; Inner++)
+			{
+				DirectoryPath const Leaf = Files.MakeDirectory(Middle, "d" + std::to_string(Inner));
+				for (unsigned int File = 0; File < 8; File++) Files.MakeFile(Leaf, "f" + std::to_string(File), "");
+			}
+		}
+		return Out;
+	}();
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		size_t Found = 0;
+		Tree.Walk([&Found](FilePath const &) { Found++; });
+		Benchmark::Keep(Found);
+	}
+});
+
+static Benchmark::Case AnnalsLog("annals/log", [](size_t Count)
+{
+	static AnnalsBase &Annals = *[](void)
+	{
+		Scratch &Files = Scratch::Get();
+		FilePath const Location = Files.MakeFile(Files.MakeDirectory("annals"), "log.txt", "");
+		AnnalsBase *Out = new AnnalsBase(Location); // Leaked so it outlives the scratch directory
+		Out->SetConsoleOutput(false);
+		Out->SetFileOutput(true, rlVerbose);
+		return Out;
+	}();
+	for (size_t Index = 0; Index < Count; Index++)
+		Annals.Log(rlDefault, "Loaded resource", "first line\nsecond line");
+});
@@ -0,0 +1,108 @@
+#include "benchmark.h"
+
+#include "../club.h"
+#include "../factory.h"
+
+// Club and factory updates over 1024 objects, an eighth of which are replaced each update
+
+namespace
+{
+
+unsigned int const Population = 1024;
+
+struct Mover : public SimpleMember<Mover>
+{
+	Mover(void) : Position(0.0f), Speed(1.0f) {}
+	float Position, Speed;
+};
+
+class MoverClub : public ActiveClub<Mover>
+{
+	protected:
+		void UpdateMember(Mover *Updatee) { Updatee->Position += Updatee->Speed; }
+};
+
+struct Particle : public Product<Particle>
+{
+	Particle(void) : Age(0) {}
+	unsigned int Age;
+};
+
+class ParticleFactory : public ActiveFactory<Particle>
+{
+	public:
+		ParticleFactory(void) : ActiveFactory<Particle>(false) {}
+	protected:
+		void UpdateProduct(Particle *Updatee) { Updatee->Age++; }
+};
+
+// The populations persist across samples, so only the churn and updates are timed
+struct ClubScene
+{
+	ClubScene(void) : Phase(0)
+	{
+		for (unsigned int Index = 0; Index < Population; Index++)
+		{
+			Members.push_back(new Mover);
+			Club.Register(Members.back());
+		}
+	}
+
+	~ClubScene(void)
+	{
+		for (auto Member : Members) delete Member;
+		Club.Clean();
+	}
+
+	MoverClub Club;
+	std::vector<Mover *> Members;
+	unsigned int Phase;
+};
+
+struct FactoryScene
+{
+	FactoryScene(void) : Phase(0)
+	{
+		for (unsigned int Index = 0; Index < Population; Index++)
+		{
+			Products.push_back(new Particle);
+			Factory.AddItem(Products.back());
+		}
+	}
+
+	ParticleFactory Factory; // Deletes the products
+	std::vector<Particle *> Products;
+	unsigned int Phase;
+};
+
+}
+
+static Benchmark::Case ClubUpdate("club/update", [](size_t Count)
+{
+	static ClubScene Scene;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		for (unsigned int Replaced = Scene.Phase++ % 8; Replaced < Population; Replaced += 8)
+		{
+			delete Scene.Members[Replaced];
+			Scene.Members[Replaced] = new Mover;
+			Scene.Club.Register(Scene.Members[Replaced]);
+		}
+		Scene.Club.Update();
+	}
+});
+
+static Benchmark::Case FactoryUpdate("factory/update", [](size_t Count)
+{
+	static FactoryScene Scene;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		for (unsigned int Replaced = Scene.Phase++ % 8; Replaced < Population; Replaced += 8)
+		{
+			Scene.Products[Replaced]->Delete();
+			Scene.Products[Replaced] = new Particle;
+			Scene.Factory.AddItem(Scene.Products[Replaced]);
+		}
+		Scene.Factory.Update();
+	}
+});
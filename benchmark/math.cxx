@@ -0,0 +1,78 @@
+#include "benchmark.h"
+
+#include "../vector.h"
+#include "../rotation.h"
+#include "../color.h"
+
+// Vector, rotation and color arithmetic
+
+static Benchmark::Case VectorAdd("vector/add", [](size_t Count)
+{
+	Vector Sum, Step(0.5f, 0.25f, 0.125f);
+	for (size_t Index = 0; Index < Count; Index++) { Sum += Step; Benchmark::Keep(Step); }
+	Benchmark::Keep(Sum);
+});
+
+static Benchmark::Case VectorNormal("vector/normal", [](size_t Count)
+{
+	Vector Current(1.0f, 2.0f, 3.0f);
+	for (size_t Index = 0; Index < Count; Index++) { Current = (Current + Vector(0.1f, 0, 0)).Normal(); }
+	Benchmark::Keep(Current);
+});
+
+static Benchmark::Case VectorCross("vector/cross", [](size_t Count)
+{
+	Vector First(1.0f, 0.0f, 0.0f), Second(0.0f, 1.0f, 0.5f);
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		Benchmark::Keep(First);
+		Vector Result = CrossProduct(First, Second);
+		Benchmark::Keep(Result);
+	}
+});
+
+static Benchmark::Case FlatVectorLength("flatvector/length", [](size_t Count)
+{
+	FlatVector Current(3.0f, 4.0f);
+	float Sum = 0.0f;
+	for (size_t Index = 0; Index < Count; Index++) { Sum += Current.Length(); Benchmark::Keep(Current); }
+	Benchmark::Keep(Sum);
+});
+
+static Benchmark::Case QuaternionMultiply("quaternion/multiply", [](size_t Count)
+{
+	Quaternion Current, Step(Vector(0.0f, 0.0f, 1.0f), Angle(0.01f));
+	for (size_t Index = 0; Index < Count; Index++) { Current *= Step; Benchmark::Keep(Step); }
+	Benchmark::Keep(Current);
+});
+
+static Benchmark::Case QuaternionInterpolate("quaternion/interpolate", [](size_t Count)
+{
+	Quaternion const From(Vector(0.0f, 0.0f, 1.0f), Angle(0.0f)), To(Vector(0.0f, 1.0f, 0.0f), Angle(2.0f));
+	float Percent = 0.0f;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		Quaternion Result = Interpolate(Percent, From, To);
+		Benchmark::Keep(Result);
+		Percent += 0.001f;
+		if (Percent > 1.0f) Percent = 0.0f;
+	}
+});
+
+static Benchmark::Case ColorChainGetColor("colorchain/getcolor", [](size_t Count)
+{
+	static ColorChain Chain = [](void)
+	{
+		ColorChain Out(Color(1.0f, 1.0f, 1.0f, 1.0f), Color(0.0f, 0.0f, 0.0f, 1.0f));
+		for (unsigned int Node = 1; Node < 16; Node++) Out.Add(Node / 16.0f, Color(Node / 16.0f, 0.5f, 0.25f, 1.0f));
+		return Out;
+	}();
+	float Position = 0.0f;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		Color Result = Chain.GetColor(Position);
+		Benchmark::Keep(Result);
+		Position += 0.0007f;
+		if (Position > 1.0f) Position = 0.0f;
+	}
+});
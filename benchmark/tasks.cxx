@@ -0,0 +1,57 @@
+#include "benchmark.h"
+
+#include "../tasks.h"
+#include "../parallel.h"
+
+#include <atomic>
+#include <thread>
+
+// Task spawning and parallel loops on the default scheduler
+
+static Benchmark::Case SpawnRoundTrip("tasks/spawn-roundtrip", [](size_t Count)
+{
+	// Time from Run until the task has run, with the workers idle
+	Tasks::Group Waiter;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		std::atomic<bool> Ran(false);
+		Waiter.Run([&Ran](void) { Ran.store(true); });
+		while (!Ran.load()) std::this_thread::yield();
+	}
+	Waiter.Wait();
+});
+
+static Benchmark::Case SpawnThroughput("tasks/spawn", [](size_t Count)
+{
+	// Empty tasks spawned from outside the scheduler
+	Tasks::Group Spawned;
+	for (size_t Index = 0; Index < Count; Index++) Spawned.Run([](void) {});
+	Spawned.Wait();
+});
+
+static unsigned long Fibonacci(unsigned int Index)
+{
+	// Recursive spawning from inside tasks exercises the local deques and stealing
+	if (Index < 2) return Index;
+	if (Index < 16) return Fibonacci(Index - 1) + Fibonacci(Index - 2);
+	unsigned long First = 0, Second = 0;
+	Tasks::Group Halves;
+	Halves.Run([&First, Index](void) { First = Fibonacci(Index - 1); });
+	Second = Fibonacci(Index - 2);
+	Halves.Wait();
+	return First + Second;
+}
+
+static Benchmark::Case NestedFibonacci("tasks/nested-fibonacci-24", [](size_t Count)
+{
+	for (size_t Index = 0; Index < Count; Index++) { unsigned long const Result = Fibonacci(24); Benchmark::Keep(Result); }
+});
+
+static Benchmark::Case ParallelForScale("parallel/for-1m", [](size_t Count)
+{
+	static std::vector<float> Values(1 << 20, 1.0f);
+	for (size_t Index = 0; Index < Count; Index++)
+		ParallelFor(Values.size(), 4096, [](size_t Begin, size_t End)
+			{ for (size_t Element = Begin; Element < End; Element++) Values[Element] = Values[Element] * 0.5f + 1.0f; });
+	Benchmark::Keep(Values[0]);
+});
@@ -0,0 +1,82 @@
+#include "benchmark.h"
+
+#include "../atom.h"
+#include "../unicode.h"
+#include "../stringbuilder.h"
+#include "../vector.h"
+
+// Interning, transcoding and string building
+
+static Benchmark::Case AtomIntern("atom/intern", [](size_t Count)
+{
+	// Mostly hits, as when names are looked up again and again
+	static std::vector<String> const Names = [](void)
+	{
+		std::vector<String> Out;
+		for (unsigned int Index = 0; Index < 256; Index++) Out.push_back("component.name." + std::to_string(Index));
+		return Out;
+	}();
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		Atom Interned(Names[Index & 255]);
+		Benchmark::Keep(Interned);
+	}
+});
+
+static Benchmark::Case AtomCompare("atom/compare", [](size_t Count)
+{
+	Atom const First("component.name.first"), Second("component.name.second");
+	size_t Matches = 0;
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		Atom const &Compared = (Index & 1) ? First : Second;
+		Benchmark::Keep(Compared);
+		if (Compared == First) Matches++;
+	}
+	Benchmark::Keep(Matches);
+});
+
+static String const &MixedText(void)
+{
+	// 4KB, mostly ASCII with some two, three and four byte sequences
+	static String const Out = [](void)
+	{
+		String Text;
+		while (Text.size() < 4096) Text += u8"Plain ASCII text runs for a while, then café, 日本, \U0001F600. ";
+		return Text;
+	}();
+	return Out;
+}
+
+static Benchmark::Case UnicodeValidate("unicode/validate-4k", [](size_t Count)
+{
+	String const &Text = MixedText();
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		bool Valid = Unicode::IsValidUTF8(Text.data(), Text.size());
+		Benchmark::Keep(Valid);
+	}
+});
+
+static Benchmark::Case UnicodeToUTF16("unicode/utf8-to-utf16-4k", [](size_t Count)
+{
+	String const &Text = MixedText();
+	std::vector<char16_t> Out(Text.size());
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		size_t Written = Unicode::UTF8ToUTF16(Text.data(), Text.size(), Out.data());
+		Benchmark::Keep(Written);
+	}
+});
+
+static Benchmark::Case StringBuilderFormat("stringbuilder/format", [](size_t Count)
+{
+	Vector const Position(1.5f, -2.25f, 3.0f);
+	for (size_t Index = 0; Index < Count; Index++)
+	{
+		StringBuilder Out;
+		Out << "entity " << static_cast<unsigned int>(Index) << " at " << Position;
+		String Result = Out;
+		Benchmark::Keep(Result);
+	}
+});
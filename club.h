@@ -5,6 +5,8 @@
 #include <list>
 #include <cassert>
 
+#include "accounting.h"
+
 /*
 The club manages objects but not their lifespans.  It simple dereferences them when they are dead.
 
@@ -15,14 +17,19 @@ The lifespan of a club must be greater than that of its members.
 */
 
 template <class MemberType> class Club;
+template <class MemberType> class EpochClub;
 
 // This is an indicator of membership in a club.  When it is deleted, it
 // removes its membership from the owning club.
 class Membership
 {
 	public:
-		Membership(bool &MemberStatus) : Active(MemberStatus) {}
-		~Membership(void) { Active = false; }
+		Membership(bool &MemberStatus) : Active(MemberStatus)
+			{ Accounting::Charge(Accounting::Tags::Club(), sizeof(Membership)); }
+		~Membership(void)
+			{ Active = false; Accounting::Refund(Accounting::Tags::Club(), sizeof(Membership)); }
+		Membership(Membership const &Other) = delete;
+		Membership &operator =(Membership const &Other) = delete;
 	private: 
 		bool &Active;
 };
@@ -35,6 +42,7 @@ template <class MemberType> class Member
 		virtual ~Member(void) {}
 	protected:
 		friend class Club<MemberType>;
+		friend class EpochClub<MemberType>;
 		virtual void Join(Membership *NewMembership) = 0;
 };
 
@@ -52,6 +60,7 @@ template <class MemberType> class Club
 				Members.begin(); CurrentMember != Members.end(); CurrentMember++)
 			{
 				assert(!(*CurrentMember)->first);
+				Accounting::Refund(Accounting::Tags::Club(), sizeof(std::pair<bool, MemberType *>));
 				delete *CurrentMember;
 			}
 		};
@@ -60,6 +69,7 @@ template <class MemberType> class Club
 		{
 			// Add a record for the member
 			Members.push_back(new std::pair<bool, MemberType *>(true, Inductee));
+			Accounting::Charge(Accounting::Tags::Club(), sizeof(std::pair<bool, MemberType *>));
 			Inductee->Join(new Membership(Members.back()->first));
 		}
 		
@@ -75,6 +85,7 @@ template <class MemberType> class Club
 				{
 					// This member has left the club, so clean up
 					// the record.
+					Accounting::Refund(Accounting::Tags::Club(), sizeof(std::pair<bool, MemberType *>));
 					delete *CurrentMember;
 
 					DeleteMember = CurrentMember;
@@ -139,6 +150,7 @@ template <class MemberType> class ActiveClub : public Club<MemberType>
 				{
 					// This member has left the club, so clean up
 					// the record.
+					Accounting::Refund(Accounting::Tags::Club(), sizeof(std::pair<bool, MemberType *>));
 					delete *CurrentMember;
 
 					DeleteMember = CurrentMember;
@@ -2,6 +2,11 @@
 #define collection_h
 
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <cassert>
 
 #include <vector>
 
@@ -25,6 +30,94 @@ template <typename ElementType, typename IteratorType> class SimpleIterable
 			{ return EndImplementation(); }
 };
 
+// LambdaIterable is a SimpleIterable that keeps the begin and end providers by their own type, so
+// there's no allocation and the calls can be inlined.  Create with MakeIterable.
+template <typename BeginFunction, typename EndFunction> class LambdaIterable
+{
+	private:
+		BeginFunction BeginImplementation;
+		EndFunction EndImplementation;
+
+	public:
+		LambdaIterable(BeginFunction const &BeginImplementation, EndFunction const &EndImplementation) :
+			BeginImplementation(BeginImplementation), EndImplementation(EndImplementation)
+			{}
+
+		decltype(std::declval<BeginFunction &>()()) begin(void)
+			{ return BeginImplementation(); }
+
+		decltype(std::declval<EndFunction &>()()) end(void)
+			{ return EndImplementation(); }
+};
+
+template <typename BeginFunction, typename EndFunction>
+	LambdaIterable<BeginFunction, EndFunction> MakeIterable(BeginFunction const &Begin, EndFunction const &End)
+	{ return LambdaIterable<BeginFunction, EndFunction>(Begin, End); }
+
+// CompactIterable is interchangeable with SimpleIterable where the providers' types must be hidden,
+// but stores them in an internal buffer rather than on the heap.  Providers that don't fit are a
+// compile error; raise BufferSize for providers with larger captures.
+template <typename ElementType, typename IteratorType, size_t BufferSize = 4 * sizeof(void *)> class CompactIterable
+{
+	private:
+		struct Operations
+		{
+			IteratorType (*Begin)(void *Providers);
+			IteratorType (*End)(void *Providers);
+			void (*Copy)(void *Destination, void const *Source);
+			void (*Destroy)(void *Providers);
+		};
+
+		template <typename BeginFunction, typename EndFunction> struct Providers
+		{
+			BeginFunction Begin;
+			EndFunction End;
+
+			static IteratorType CallBegin(void *Erased) { return static_cast<Providers *>(Erased)->Begin(); }
+			static IteratorType CallEnd(void *Erased) { return static_cast<Providers *>(Erased)->End(); }
+			static void Copy(void *Destination, void const *Source) { new (Destination) Providers(*static_cast<Providers const *>(Source)); }
+			static void Destroy(void *Erased) { static_cast<Providers *>(Erased)->~Providers(); }
+			static Operations const *Table(void)
+			{
+				static Operations const Out {&CallBegin, &CallEnd, &Copy, &Destroy};
+				return &Out;
+			}
+		};
+
+		typename std::aligned_storage<BufferSize, alignof(std::max_align_t)>::type Buffer;
+		Operations const *Implementation;
+
+	public:
+		template <typename BeginFunction, typename EndFunction> CompactIterable(BeginFunction const &BeginImplementation, EndFunction const &EndImplementation)
+		{
+			typedef Providers<BeginFunction, EndFunction> StoredType;
+			static_assert(sizeof(StoredType) <= BufferSize, "CompactIterable providers are too large for the buffer; increase BufferSize.");
+			static_assert(alignof(StoredType) <= alignof(std::max_align_t), "CompactIterable providers are over-aligned.");
+			new (&Buffer) StoredType {BeginImplementation, EndImplementation};
+			Implementation = StoredType::Table();
+		}
+
+		CompactIterable(CompactIterable<ElementType, IteratorType, BufferSize> const &Other) : Implementation(Other.Implementation)
+			{ Implementation->Copy(&Buffer, &Other.Buffer); }
+
+		CompactIterable<ElementType, IteratorType, BufferSize> &operator =(CompactIterable<ElementType, IteratorType, BufferSize> const &Other)
+		{
+			if (&Other == this) return *this;
+			Implementation->Destroy(&Buffer);
+			Implementation = Other.Implementation;
+			Implementation->Copy(&Buffer, &Other.Buffer);
+			return *this;
+		}
+
+		~CompactIterable(void) { Implementation->Destroy(&Buffer); }
+
+		IteratorType begin(void)
+			{ return Implementation->Begin(&Buffer); }
+
+		IteratorType end(void)
+			{ return Implementation->End(&Buffer); }
+};
+
 // IndexIterable requires a count method and a value getter method and iterates based on those.
 template <typename CoreType> class IndexIterable
 {
@@ -42,12 +135,16 @@ template <typename CoreType> class IndexIterable
 			public:					
 				Iterator(CoreType &Base) : Base(Base), Position(0) {}
 				void operator++(void) { Position++; }
-				bool operator!=(Iterator const &) { return Position < Base.GetCount(); }
+				bool operator!=(Iterator const &) const { return Position < Base.GetCount(); }
 				ValueType &operator*(void) { return Base.GetValue(Position); }
 		};
 			
 		IndexIterable(CoreType const &Base) : Base(Base) {}
 		virtual ~IndexIterable(void) {}
+
+		// Random access, for consumers that split the index space (see ParallelForEach)
+		IndexType GetCount(void) { return Base.GetCount(); }
+		ValueType &GetValue(IndexType Index) { return Base.GetValue(Index); }
 		
 		Iterator begin(void) { return Iterator(Base); }
 		
@@ -97,4 +194,205 @@ template <typename ElementType> class VectorIteratorRange : public IteratorRange
 			{}
 };
 
+// ========================================================================
+// Lazy adapters
+// These wrap any iterable (including each other) and do their work as they are iterated, so a
+// chain of them is one pass with no intermediate containers.  Iterables passed as lvalues are
+// referenced and must outlive the adapter; temporaries, like other adapters, are kept by value.
+// Example: for (auto Pair : Lazy::Enumerate(Lazy::Filter(Entities, IsAlive))) ...
+namespace Lazy
+{
+	template <typename BaseType> struct Traits
+	{
+		typedef decltype(std::declval<BaseType &>().begin()) Iterator;
+		typedef decltype(*std::declval<Iterator &>()) Reference;
+	};
+
+	template <typename BaseType, typename PredicateType> class FilterIterable
+	{
+		private:
+			typedef typename Traits<BaseType>::Iterator BaseIterator;
+			BaseType Base;
+			PredicateType Predicate;
+
+		public:
+			class Iterator
+			{
+				private:
+					BaseIterator Position, End;
+					PredicateType const *Predicate;
+					void Skip(void) { while ((Position != End) && !(*Predicate)(*Position)) ++Position; }
+				public:
+					Iterator(BaseIterator Position, BaseIterator End, PredicateType const *Predicate) :
+						Position(Position), End(End), Predicate(Predicate)
+						{ Skip(); }
+					void operator++(void) { ++Position; Skip(); }
+					bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+					typename Traits<BaseType>::Reference operator*(void) { return *Position; }
+			};
+
+			FilterIterable(BaseType &&Base, PredicateType const &Predicate) : Base(std::forward<BaseType>(Base)), Predicate(Predicate) {}
+			Iterator begin(void) { return Iterator(Base.begin(), Base.end(), &Predicate); }
+			Iterator end(void) { return Iterator(Base.end(), Base.end(), &Predicate); }
+	};
+
+	template <typename BaseType, typename FunctionType> class TransformIterable
+	{
+		private:
+			typedef typename Traits<BaseType>::Iterator BaseIterator;
+			BaseType Base;
+			FunctionType Function;
+
+		public:
+			class Iterator
+			{
+				private:
+					BaseIterator Position;
+					FunctionType const *Function;
+				public:
+					Iterator(BaseIterator Position, FunctionType const *Function) : Position(Position), Function(Function) {}
+					void operator++(void) { ++Position; }
+					bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+					decltype(std::declval<FunctionType const &>()(std::declval<typename Traits<BaseType>::Reference>())) operator*(void)
+						{ return (*Function)(*Position); }
+			};
+
+			TransformIterable(BaseType &&Base, FunctionType const &Function) : Base(std::forward<BaseType>(Base)), Function(Function) {}
+			Iterator begin(void) { return Iterator(Base.begin(), &Function); }
+			Iterator end(void) { return Iterator(Base.end(), &Function); }
+	};
+
+	// Yields (index, element) pairs
+	template <typename BaseType> class EnumerateIterable
+	{
+		private:
+			typedef typename Traits<BaseType>::Iterator BaseIterator;
+			BaseType Base;
+
+		public:
+			class Iterator
+			{
+				private:
+					BaseIterator Position;
+					size_t Index;
+				public:
+					Iterator(BaseIterator Position) : Position(Position), Index(0) {}
+					void operator++(void) { ++Position; ++Index; }
+					bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+					std::pair<size_t, typename Traits<BaseType>::Reference> operator*(void)
+						{ return std::pair<size_t, typename Traits<BaseType>::Reference>(Index, *Position); }
+			};
+
+			EnumerateIterable(BaseType &&Base) : Base(std::forward<BaseType>(Base)) {}
+			Iterator begin(void) { return Iterator(Base.begin()); }
+			Iterator end(void) { return Iterator(Base.end()); }
+	};
+
+	// Yields IteratorRanges of up to Size consecutive elements
+	template <typename BaseType> class ChunkIterable
+	{
+		private:
+			typedef typename Traits<BaseType>::Iterator BaseIterator;
+			BaseType Base;
+			size_t Size;
+
+		public:
+			class Iterator
+			{
+				private:
+					BaseIterator Position, End;
+					size_t Size;
+				public:
+					Iterator(BaseIterator Position, BaseIterator End, size_t Size) : Position(Position), End(End), Size(Size) {}
+					void operator++(void) { for (size_t Step = 0; (Step < Size) && (Position != End); Step++) ++Position; }
+					bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+					IteratorRange<BaseIterator> operator*(void)
+					{
+						BaseIterator ChunkEnd(Position);
+						for (size_t Step = 0; (Step < Size) && (ChunkEnd != End); Step++) ++ChunkEnd;
+						return IteratorRange<BaseIterator>(Position, ChunkEnd);
+					}
+			};
+
+			ChunkIterable(BaseType &&Base, size_t Size) : Base(std::forward<BaseType>(Base)), Size(Size) { assert(Size > 0); }
+			Iterator begin(void) { return Iterator(Base.begin(), Base.end(), Size); }
+			Iterator end(void) { return Iterator(Base.end(), Base.end(), Size); }
+	};
+
+	// Yields every Step-th element, starting with the first
+	template <typename BaseType> class StrideIterable
+	{
+		private:
+			typedef typename Traits<BaseType>::Iterator BaseIterator;
+			BaseType Base;
+			size_t Step;
+
+		public:
+			class Iterator
+			{
+				private:
+					BaseIterator Position, End;
+					size_t Step;
+				public:
+					Iterator(BaseIterator Position, BaseIterator End, size_t Step) : Position(Position), End(End), Step(Step) {}
+					void operator++(void) { for (size_t Count = 0; (Count < Step) && (Position != End); Count++) ++Position; }
+					bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+					typename Traits<BaseType>::Reference operator*(void) { return *Position; }
+			};
+
+			StrideIterable(BaseType &&Base, size_t Step) : Base(std::forward<BaseType>(Base)), Step(Step) { assert(Step > 0); }
+			Iterator begin(void) { return Iterator(Base.begin(), Base.end(), Step); }
+			Iterator end(void) { return Iterator(Base.end(), Base.end(), Step); }
+	};
+
+	// Yields pairs of elements from two iterables, stopping at the end of the shorter one
+	template <typename FirstType, typename SecondType> class ZipIterable
+	{
+		private:
+			typedef typename Traits<FirstType>::Iterator FirstIterator;
+			typedef typename Traits<SecondType>::Iterator SecondIterator;
+			FirstType First;
+			SecondType Second;
+
+		public:
+			class Iterator
+			{
+				private:
+					FirstIterator FirstPosition;
+					SecondIterator SecondPosition;
+				public:
+					Iterator(FirstIterator FirstPosition, SecondIterator SecondPosition) : FirstPosition(FirstPosition), SecondPosition(SecondPosition) {}
+					void operator++(void) { ++FirstPosition; ++SecondPosition; }
+					bool operator!=(Iterator const &Other) const { return (FirstPosition != Other.FirstPosition) && (SecondPosition != Other.SecondPosition); }
+					std::pair<typename Traits<FirstType>::Reference, typename Traits<SecondType>::Reference> operator*(void)
+					{
+						return std::pair<typename Traits<FirstType>::Reference, typename Traits<SecondType>::Reference>(
+							*FirstPosition, *SecondPosition);
+					}
+			};
+
+			ZipIterable(FirstType &&First, SecondType &&Second) : First(std::forward<FirstType>(First)), Second(std::forward<SecondType>(Second)) {}
+			Iterator begin(void) { return Iterator(First.begin(), Second.begin()); }
+			Iterator end(void) { return Iterator(First.end(), Second.end()); }
+	};
+
+	template <typename BaseType, typename PredicateType> FilterIterable<BaseType, PredicateType> Filter(BaseType &&Base, PredicateType const &Predicate)
+		{ return FilterIterable<BaseType, PredicateType>(std::forward<BaseType>(Base), Predicate); }
+
+	template <typename BaseType, typename FunctionType> TransformIterable<BaseType, FunctionType> Transform(BaseType &&Base, FunctionType const &Function)
+		{ return TransformIterable<BaseType, FunctionType>(std::forward<BaseType>(Base), Function); }
+
+	template <typename BaseType> EnumerateIterable<BaseType> Enumerate(BaseType &&Base)
+		{ return EnumerateIterable<BaseType>(std::forward<BaseType>(Base)); }
+
+	template <typename BaseType> ChunkIterable<BaseType> Chunk(BaseType &&Base, size_t Size)
+		{ return ChunkIterable<BaseType>(std::forward<BaseType>(Base), Size); }
+
+	template <typename BaseType> StrideIterable<BaseType> Stride(BaseType &&Base, size_t Step)
+		{ return StrideIterable<BaseType>(std::forward<BaseType>(Base), Step); }
+
+	template <typename FirstType, typename SecondType> ZipIterable<FirstType, SecondType> Zip(FirstType &&First, SecondType &&Second)
+		{ return ZipIterable<FirstType, SecondType>(std::forward<FirstType>(First), std::forward<SecondType>(Second)); }
+}
+
 #endif
@@ -1,10 +1,10 @@
 #include "color.h"
 
-#include "inputoutput.h"
+#include "stringbuilder.h"
 
 // Color //////////////////////////////////////////////////////////////////////
 String Color::AsString(void) const
-	{ MemoryStream Out; Out << "(C " << Red << ", " << Green << ", " << Blue << ", " << Alpha << ")"; return Out; }
+	{ return StringBuilder() << *this; }
 
 Color Color::operator + (const Color &Operand) const
 	{ return Color(Red + Operand.Red, Green + Operand.Green, Blue + Operand.Blue, Alpha); }
@@ -0,0 +1,148 @@
+#ifndef concurrentpool_h
+#define concurrentpool_h
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cassert>
+
+#include "pool.h"
+
+/*
+Concurrent pools are pools that may be shared between threads.
+
+References are hashed into shards, each with its own lock, so lookups of unrelated references
+rarely contend and pruning only holds one shard at a time.  Items are constructed outside of the
+shard lock; other threads asking for the same reference wait for that construction rather than
+constructing a duplicate.
+*/
+
+template <typename ReferenceType, class ItemType, class Hasher, unsigned int ShardCount> class ConcurrentPool;
+
+template <typename ReferenceType, class ItemType> class ConcurrentPoolItem
+{
+	public:
+		ConcurrentPoolItem(void) : Bindings(0) {}
+		// Bindings only rise from zero under the shard lock, which pruning also holds
+		void Reserve(void) { Bindings.fetch_add(1, std::memory_order_relaxed); }
+		void Release(void) { int Previous = Bindings.fetch_sub(1, std::memory_order_acq_rel); assert(Previous > 0); (void)Previous; }
+	template <typename, class, class, unsigned int> friend class ConcurrentPool;
+	protected:
+		~ConcurrentPoolItem(void) {}
+		bool ShouldBeDeleted(void) { return Bindings.load(std::memory_order_acquire) <= 0; }
+	private:
+		std::atomic<int> Bindings;
+};
+
+template <typename ReferenceType, class ItemType, class Hasher = std::hash<ReferenceType>, unsigned int ShardCount = 16> class ConcurrentPool
+{
+	static_assert((ShardCount & (ShardCount - 1)) == 0, "ConcurrentPool shard count must be a power of 2.");
+	public:
+		~ConcurrentPool(void)
+		{
+			for (auto &CurrentShard : Shards)
+				for (auto &CurrentItem : CurrentShard.Items)
+				{
+					assert(CurrentItem.second != nullptr); // Still being constructed
+					assert(CurrentItem.second->ShouldBeDeleted());
+					Accounting::Refund(Accounting::Tags::Pool(), sizeof(ItemType));
+					delete CurrentItem.second;
+				}
+		}
+
+		Access<ItemType> Get(const ReferenceType &Reference)
+		{
+			Shard &Owner = Select(Reference);
+			std::unique_lock<std::mutex> Lock(Owner.Mutex);
+			while (true)
+			{
+				auto Found = Owner.Items.find(Reference);
+				if (Found == Owner.Items.end()) break;
+				if (Found->second != nullptr) return Access<ItemType>(Found->second);
+				Owner.Constructed.wait(Lock);
+			}
+
+			// Leave a placeholder so concurrent requests wait instead of constructing again.
+			// References to map values survive rehashing, and only this thread erases the placeholder.
+			ItemType *&Placeholder = Owner.Items.emplace(Reference, nullptr).first->second;
+			Lock.unlock();
+
+			ItemType *Creation;
+			try { Creation = new ItemType(Reference); }
+			catch (...)
+			{
+				Lock.lock();
+				Owner.Items.erase(Reference);
+				Lock.unlock();
+				Owner.Constructed.notify_all();
+				throw;
+			}
+
+			Accounting::Charge(Accounting::Tags::Pool(), sizeof(ItemType));
+			Lock.lock();
+			Placeholder = Creation;
+			Access<ItemType> Out(Creation);
+			Lock.unlock();
+			Owner.Constructed.notify_all();
+			return Out;
+		}
+
+		void Add(const ReferenceType &Reference, ItemType *Addee)
+		{
+			Shard &Owner = Select(Reference);
+			std::lock_guard<std::mutex> Lock(Owner.Mutex);
+			assert(Owner.Items.find(Reference) == Owner.Items.end());
+			Accounting::Charge(Accounting::Tags::Pool(), sizeof(ItemType));
+			Owner.Items[Reference] = Addee;
+		}
+
+		// May run while other threads are getting items.  Unreferenced items are unlinked under
+		// their shard's lock and deleted after it is released.
+		void Prune(void)
+		{
+			std::vector<ItemType *> Releasable;
+			for (auto &CurrentShard : Shards)
+			{
+				{
+					std::lock_guard<std::mutex> Lock(CurrentShard.Mutex);
+					for (auto CurrentItem = CurrentShard.Items.begin(); CurrentItem != CurrentShard.Items.end(); )
+					{
+						if ((CurrentItem->second != nullptr) && CurrentItem->second->ShouldBeDeleted())
+						{
+							Releasable.push_back(CurrentItem->second);
+							CurrentItem = CurrentShard.Items.erase(CurrentItem);
+						}
+						else CurrentItem++;
+					}
+				}
+				for (auto Releasee : Releasable)
+				{
+					Accounting::Refund(Accounting::Tags::Pool(), sizeof(ItemType));
+					delete Releasee;
+				}
+				Releasable.clear();
+			}
+		}
+
+	private:
+		struct alignas(64) Shard
+		{
+			std::mutex Mutex;
+			std::condition_variable Constructed;
+			std::unordered_map<ReferenceType, ItemType *, Hasher> Items;
+		};
+
+		Shard &Select(const ReferenceType &Reference)
+		{
+			uint64_t Mixed = static_cast<uint64_t>(Hasher()(Reference)) * 0x9E3779B97F4A7C15ull;
+			return Shards[(Mixed >> 32) & (ShardCount - 1)];
+		}
+
+		Shard Shards[ShardCount];
+};
+
+#endif
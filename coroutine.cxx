@@ -0,0 +1,197 @@
+#include "coroutine.h"
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include <algorithm>
+#include <new>
+
+#include "time.h"
+
+namespace Script
+{
+
+// ========================================================================
+// Frame pools
+// Frames are rounded up to 64 byte classes; anything over 1KB goes straight to the heap.  Each
+// thread keeps its own lists, and frames freed on another thread simply join that thread's lists.
+
+namespace Frames
+{
+	static size_t const ClassSize = 64, ClassCount = 16;
+
+	struct FreeFrame { FreeFrame *Next; };
+
+	struct Pool
+	{
+		FreeFrame *Lists[ClassCount] = {};
+		~Pool(void)
+		{
+			for (auto &List : Lists)
+				while (List != nullptr)
+				{
+					FreeFrame *Next = List->Next;
+					::operator delete(List);
+					List = Next;
+				}
+			Destroyed = true;
+		}
+		static thread_local bool Destroyed; // Frames freed during thread exit bypass the pool
+	};
+	thread_local bool Pool::Destroyed = false;
+	static thread_local Pool LocalPool;
+
+	void *Allocate(size_t Size)
+	{
+		size_t const Class = (Size - 1) / ClassSize;
+		if ((Class >= ClassCount) || Pool::Destroyed) return ::operator new(Size);
+		FreeFrame *&List = LocalPool.Lists[Class];
+		if (List == nullptr) return ::operator new((Class + 1) * ClassSize);
+		FreeFrame *Out = List;
+		List = Out->Next;
+		return Out;
+	}
+
+	void Free(void *Frame, size_t Size) noexcept
+	{
+		size_t const Class = (Size - 1) / ClassSize;
+		if ((Class >= ClassCount) || Pool::Destroyed)
+		{
+			::operator delete(Frame);
+			return;
+		}
+		FreeFrame *Freed = static_cast<FreeFrame *>(Frame);
+		Freed->Next = LocalPool.Lists[Class];
+		LocalPool.Lists[Class] = Freed;
+	}
+}
+
+// ========================================================================
+// Scheduler
+
+Scheduler::Scheduler(void) : SleepSequence(0) {}
+
+Scheduler::~Scheduler(void)
+{
+	// Children are owned by their parents' frames, so destroying the roots frees everything
+	for (auto &Current : Finished) Current.Handle.destroy();
+	for (auto &Current : Roots) Current.Handle.destroy();
+}
+
+void Scheduler::Update(void)
+{
+	Running.clear();
+	Running.swap(Ready);
+
+	float const Time = Now();
+	while (!Sleepers.empty() && (Sleepers.front().Until <= Time))
+	{
+		Running.push_back(Sleepers.front().Sleeper);
+		std::pop_heap(Sleepers.begin(), Sleepers.end());
+		Sleepers.pop_back();
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(PostedMutex);
+		Running.insert(Running.end(), Posted.begin(), Posted.end());
+		Posted.clear();
+	}
+
+	for (auto &Resumee : Running) Resumee.resume();
+
+	std::exception_ptr Failure;
+	for (auto &Current : Finished)
+	{
+		if (!Failure) Failure = Current.Promise->Failure;
+		Current.Handle.destroy();
+	}
+	Finished.clear();
+	if (Failure) std::rethrow_exception(Failure);
+}
+
+size_t Scheduler::GetCount(void) const { return Roots.size(); }
+
+float Scheduler::Now(void) const { return Clock::Get().UnpausedSeconds(); }
+
+void Scheduler::Schedule(std::coroutine_handle<> Resumee) { Ready.push_back(Resumee); }
+
+void Scheduler::Sleep(std::coroutine_handle<> Sleeper, float Until)
+{
+	Sleepers.push_back(Sleeping {Until, SleepSequence++, Sleeper});
+	std::push_heap(Sleepers.begin(), Sleepers.end());
+}
+
+void Scheduler::Post(std::coroutine_handle<> Resumee)
+{
+	std::lock_guard<std::mutex> Lock(PostedMutex);
+	Posted.push_back(Resumee);
+}
+
+void Scheduler::Retire(PromiseBase &Promise, std::coroutine_handle<> Handle)
+{
+	// Swap-remove from the roots; the frame is destroyed once the batch is done resuming
+	size_t const Index = Promise.RootIndex;
+	assert(Index < Roots.size());
+	Roots[Index] = Roots.back();
+	Roots[Index].Promise->RootIndex = Index;
+	Roots.pop_back();
+	Finished.push_back(Root {Handle, &Promise});
+}
+
+// ========================================================================
+// Event
+
+Event::Event(void) : Signalled(false), Waiters(nullptr) {}
+
+Event::~Event(void) { assert(Waiters == nullptr); }
+
+void Event::Signal(void)
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+	Signalled = true;
+	while (Waiters != nullptr)
+	{
+		Awaiter *Woken = Waiters;
+		Waiters = Woken->Next;
+		Woken->Linked = false;
+		Woken->Owner->Post(Woken->Waiter);
+	}
+}
+
+void Event::Reset(void)
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+	Signalled = false;
+}
+
+bool Event::IsSignalled(void) const
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+	return Signalled;
+}
+
+Event::Awaiter::~Awaiter(void)
+{
+	std::lock_guard<std::mutex> Lock(Target.Mutex);
+	if (!Linked) return;
+	if (Previous != nullptr) Previous->Next = Next;
+	else Target.Waiters = Next;
+	if (Next != nullptr) Next->Previous = Previous;
+}
+
+bool Event::Awaiter::Suspend(Scheduler *Owner, std::coroutine_handle<> Waiter)
+{
+	std::lock_guard<std::mutex> Lock(Target.Mutex);
+	if (Target.Signalled) return false;
+	this->Owner = Owner;
+	this->Waiter = Waiter;
+	Previous = nullptr;
+	Next = Target.Waiters;
+	if (Next != nullptr) Next->Previous = this;
+	Target.Waiters = this;
+	Linked = true;
+	return true;
+}
+
+}
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef coroutine_h
+#define coroutine_h
+
+// Needs C++20 coroutines; empty otherwise
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <cassert>
+
+/*
+Scripts are coroutines that run a little each frame.
+
+	Script::Task<> Patrol(Guard &Walker)
+	{
+		while (true)
+		{
+			Walker.Turn();
+			co_await Script::Delay(2.0f);
+			co_await Walker.Arrived; // A Script::Event
+		}
+	}
+	...
+	Scripts.Start(Patrol(Someone));
+	...
+	Scripts.Update(); // Once a frame, after the Clock
+
+Tasks start suspended and first run on the scheduler's next Update.  Delays are in unpaused Clock
+time.  Awaiting another task runs it inside the awaiting one and yields its result.  Frames come
+from per-thread pools and awaiting allocates nothing, so thousands of scripts are cheap.
+*/
+
+namespace Script
+{
+
+class Scheduler;
+
+// Size-classed free lists for coroutine frames
+namespace Frames
+{
+	void *Allocate(size_t Size);
+	void Free(void *Frame, size_t Size) noexcept;
+}
+
+class PromiseBase
+{
+	public:
+		static void *operator new(size_t Size) { return Frames::Allocate(Size); }
+		static void operator delete(void *Frame, size_t Size) noexcept { Frames::Free(Frame, Size); }
+
+		std::suspend_always initial_suspend(void) noexcept { return {}; }
+
+		struct FinalAwaiter
+		{
+			bool await_ready(void) noexcept { return false; }
+			template <typename PromiseType> std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> Finished) noexcept;
+			void await_resume(void) noexcept {}
+		};
+		FinalAwaiter final_suspend(void) noexcept { return {}; }
+
+		void unhandled_exception(void) { Failure = std::current_exception(); }
+
+		Scheduler *Owner = nullptr;
+		std::coroutine_handle<> Continuation; // The awaiting task, if not a root
+		size_t RootIndex = size_t(-1);
+		std::exception_ptr Failure;
+};
+
+template <typename ResultType> class ResultPromise : public PromiseBase
+{
+	public:
+		template <typename ValueType> void return_value(ValueType &&Value) { Result.emplace(std::forward<ValueType>(Value)); }
+		ResultType Take(void) { return std::move(*Result); }
+	private:
+		std::optional<ResultType> Result;
+};
+
+template <> class ResultPromise<void> : public PromiseBase
+{
+	public:
+		void return_void(void) {}
+		void Take(void) {}
+};
+
+template <typename ResultType = void> class Task
+{
+	public:
+		struct promise_type : ResultPromise<ResultType>
+		{
+			Task get_return_object(void) { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		};
+
+		Task(Task &&Other) noexcept : Handle(std::exchange(Other.Handle, nullptr)) {}
+		Task &operator =(Task &&Other) noexcept
+		{
+			if (Handle) Handle.destroy();
+			Handle = std::exchange(Other.Handle, nullptr);
+			return *this;
+		}
+		Task(Task const &Other) = delete;
+		Task &operator =(Task const &Other) = delete;
+		~Task(void) { if (Handle) Handle.destroy(); }
+
+		bool IsDone(void) const { return !Handle || Handle.done(); }
+
+		struct Awaiter
+		{
+			std::coroutine_handle<promise_type> Handle;
+			bool await_ready(void) const noexcept { return Handle.done(); }
+			template <typename PromiseType> std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> Awaiting) noexcept
+			{
+				Handle.promise().Owner = Awaiting.promise().Owner;
+				Handle.promise().Continuation = Awaiting;
+				return Handle;
+			}
+			ResultType await_resume(void)
+			{
+				if (Handle.promise().Failure) std::rethrow_exception(Handle.promise().Failure);
+				return Handle.promise().Take();
+			}
+		};
+		Awaiter operator co_await(void) && { assert(Handle); return Awaiter {Handle}; }
+
+	private:
+		friend class Scheduler;
+		explicit Task(std::coroutine_handle<promise_type> Handle) : Handle(Handle) {}
+		std::coroutine_handle<promise_type> Handle;
+};
+
+class Scheduler
+{
+	public:
+		Scheduler(void);
+		~Scheduler(void); // Destroys unfinished tasks
+		Scheduler(Scheduler const &Other) = delete;
+		Scheduler &operator =(Scheduler const &Other) = delete;
+
+		template <typename ResultType> void Start(Task<ResultType> &&Started)
+		{
+			auto Handle = std::exchange(Started.Handle, nullptr);
+			assert(Handle);
+			Handle.promise().Owner = this;
+			Handle.promise().RootIndex = Roots.size();
+			Roots.push_back(Root {Handle, &Handle.promise()});
+			Schedule(Handle);
+		}
+
+		// Resumes every task that is due.  Rethrows the first exception that ended a task.
+		void Update(void);
+
+		size_t GetCount(void) const; // Unfinished started tasks
+
+		// For awaitables
+		float Now(void) const;
+		void Schedule(std::coroutine_handle<> Resumee); // Next Update
+		void Sleep(std::coroutine_handle<> Sleeper, float Until);
+		void Post(std::coroutine_handle<> Resumee); // Next Update, from any thread
+		void Retire(PromiseBase &Finished, std::coroutine_handle<> Handle);
+
+	private:
+		struct Root { std::coroutine_handle<> Handle; PromiseBase *Promise; };
+		struct Sleeping
+		{
+			float Until;
+			unsigned long Sequence;
+			std::coroutine_handle<> Sleeper;
+			bool operator <(Sleeping const &Other) const // Earliest on top of the heap
+				{ return (Until > Other.Until) || ((Until == Other.Until) && (Sequence > Other.Sequence)); }
+		};
+
+		std::vector<Root> Roots;
+		std::vector<std::coroutine_handle<> > Ready, Running;
+		std::vector<Sleeping> Sleepers;
+		unsigned long SleepSequence;
+		std::vector<Root> Finished;
+
+		std::mutex PostedMutex;
+		std::vector<std::coroutine_handle<> > Posted;
+};
+
+template <typename PromiseType> std::coroutine_handle<> PromiseBase::FinalAwaiter::await_suspend(std::coroutine_handle<PromiseType> Finished) noexcept
+{
+	PromiseBase &Promise = Finished.promise();
+	if (Promise.Continuation) return Promise.Continuation;
+	Promise.Owner->Retire(Promise, Finished);
+	return std::noop_coroutine();
+}
+
+// ========================================================================
+// Awaitables
+
+// Resumes once Seconds of unpaused Clock time have passed
+struct Delay
+{
+	explicit Delay(float Seconds) : Seconds(Seconds) {}
+	bool await_ready(void) const noexcept { return Seconds <= 0.0f; }
+	template <typename PromiseType> void await_suspend(std::coroutine_handle<PromiseType> Sleeper)
+	{
+		Scheduler &Owner = *Sleeper.promise().Owner;
+		Owner.Sleep(Sleeper, Owner.Now() + Seconds);
+	}
+	void await_resume(void) noexcept {}
+	float Seconds;
+};
+
+// Resumes on the scheduler's next Update
+struct NextFrame
+{
+	bool await_ready(void) const noexcept { return false; }
+	template <typename PromiseType> void await_suspend(std::coroutine_handle<PromiseType> Resumee)
+		{ Resumee.promise().Owner->Schedule(Resumee); }
+	void await_resume(void) noexcept {}
+};
+
+// A flag that tasks can wait for.  Signal may be called from any thread, such as on I/O
+// completion; waiting tasks resume on their scheduler's next Update.
+class Event
+{
+	public:
+		Event(void);
+		~Event(void);
+		Event(Event const &Other) = delete;
+		Event &operator =(Event const &Other) = delete;
+
+		void Signal(void);
+		void Reset(void);
+		bool IsSignalled(void) const;
+
+		// Lives in the awaiting frame, so waiting allocates nothing
+		class Awaiter
+		{
+			public:
+				Awaiter(Event &Target) : Target(Target) {}
+				Awaiter(Awaiter const &Other) : Target(Other.Target) {}
+				~Awaiter(void); // Unlinks if the waiting task is destroyed
+				bool await_ready(void) const { return Target.IsSignalled(); }
+				template <typename PromiseType> bool await_suspend(std::coroutine_handle<PromiseType> Waiter)
+					{ return Suspend(Waiter.promise().Owner, Waiter); }
+				void await_resume(void) noexcept {}
+			private:
+				friend class Event;
+				bool Suspend(Scheduler *Owner, std::coroutine_handle<> Waiter);
+				Event &Target;
+				Scheduler *Owner = nullptr;
+				std::coroutine_handle<> Waiter;
+				Awaiter *Previous = nullptr, *Next = nullptr;
+				bool Linked = false;
+		};
+		Awaiter operator co_await(void) { return Awaiter(*this); }
+
+	private:
+		mutable std::mutex Mutex;
+		bool Signalled;
+		Awaiter *Waiters;
+};
+
+}
+
+#endif
+
+#endif
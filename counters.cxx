@@ -0,0 +1,235 @@
+#include "counters.h"
+
+#include <chrono>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <cstring>
+#define COUNTERS_PERF
+#endif
+
+#include "singleton.h"
+#include "stringbuilder.h"
+
+namespace Counters
+{
+
+char const *GetName(Event Named)
+{
+	switch (Named)
+	{
+		case Cycles: return "cycles";
+		case Instructions: return "instructions";
+		case CacheMisses: return "cache-misses";
+		case BranchMisses: return "branch-misses";
+		default: return "unknown";
+	}
+}
+
+Reading::Reading(void) : Valid(0)
+	{ for (auto &Value : Values) Value = 0; }
+
+Reading Reading::operator -(Reading const &Start) const
+{
+	Reading Out;
+	Out.Valid = Valid & Start.Valid;
+	for (unsigned int Index = 0; Index < EventCount; Index++)
+		Out.Values[Index] = (Values[Index] > Start.Values[Index]) ? Values[Index] - Start.Values[Index] : 0;
+	return Out;
+}
+
+Reading &Reading::operator +=(Reading const &Other)
+{
+	Valid |= Other.Valid;
+	for (unsigned int Index = 0; Index < EventCount; Index++) Values[Index] += Other.Values[Index];
+	return *this;
+}
+
+// ========================================================================
+// Per thread counters
+
+class ThreadCounters : public ThreadSingleton<ThreadCounters>
+{
+	public:
+		ThreadCounters(void);
+		~ThreadCounters(void);
+		Reading Read(void) const;
+		bool IsAvailable(void) const { return Opened > 0; }
+
+	private:
+#ifdef COUNTERS_PERF
+		int Descriptors[EventCount];
+		Event Order[EventCount]; // Group members in read order
+#endif
+		unsigned int Opened;
+};
+
+#ifdef COUNTERS_PERF
+static int OpenEvent(uint64_t Config, int Group)
+{
+	perf_event_attr Attributes;
+	memset(&Attributes, 0, sizeof(Attributes));
+	Attributes.size = sizeof(Attributes);
+	Attributes.type = PERF_TYPE_HARDWARE;
+	Attributes.config = Config;
+	Attributes.disabled = (Group == -1) ? 1 : 0;
+	Attributes.exclude_kernel = 1; // Allowed at the default paranoia level
+	Attributes.exclude_hv = 1;
+	Attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return static_cast<int>(syscall(__NR_perf_event_open, &Attributes, 0, -1, Group, 0));
+}
+#endif
+
+ThreadCounters::ThreadCounters(void) : Opened(0)
+{
+#ifdef COUNTERS_PERF
+	uint64_t const Configs[EventCount] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+	for (auto &Descriptor : Descriptors) Descriptor = -1;
+
+	// The first event that opens leads the group, so all are scheduled together
+	for (unsigned int Index = 0; Index < EventCount; Index++)
+	{
+		int const Descriptor = OpenEvent(Configs[Index], (Opened == 0) ? -1 : Descriptors[0]);
+		if (Descriptor == -1) continue;
+		Descriptors[Opened] = Descriptor;
+		Order[Opened] = static_cast<Event>(Index);
+		Opened++;
+	}
+	if (Opened > 0)
+	{
+		ioctl(Descriptors[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(Descriptors[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+#endif
+}
+
+ThreadCounters::~ThreadCounters(void)
+{
+#ifdef COUNTERS_PERF
+	for (unsigned int Index = 0; Index < Opened; Index++) close(Descriptors[Index]);
+#endif
+}
+
+Reading ThreadCounters::Read(void) const
+{
+	Reading Out;
+#ifdef COUNTERS_PERF
+	if (Opened == 0) return Out;
+	uint64_t Buffer[3 + EventCount];
+	ssize_t const Length = read(Descriptors[0], Buffer, sizeof(Buffer));
+	if ((Length < static_cast<ssize_t>(3 * sizeof(uint64_t))) || (Buffer[0] != Opened)) return Out;
+	uint64_t const Enabled = Buffer[1], Running = Buffer[2];
+	if (Running == 0) return Out;
+	for (unsigned int Index = 0; Index < Opened; Index++)
+	{
+		uint64_t Value = Buffer[3 + Index];
+		if (Running < Enabled) Value = static_cast<uint64_t>(static_cast<double>(Value) * Enabled / Running);
+		Out.Values[Order[Index]] = Value;
+		Out.Valid |= 1u << Order[Index];
+	}
+#endif
+	return Out;
+}
+
+bool IsAvailable(void) { return ThreadCounters::Get().IsAvailable(); }
+
+Reading Read(void) { return ThreadCounters::Get().Read(); }
+
+Scope::Scope(Reading &Total) : Total(Total), Start(Read()) {}
+
+Scope::~Scope(void) { Total += Read() - Start; }
+
+// ========================================================================
+// Zones
+
+static std::atomic<Zone *> &ZoneHead(void)
+{
+	static std::atomic<Zone *> Head(nullptr);
+	return Head;
+}
+
+Zone::Zone(char const *Name) : Name(Name), Calls(0), Nanoseconds(0), Valid(0)
+{
+	for (auto &Value : Values) Value.store(0, std::memory_order_relaxed);
+	Next = ZoneHead().load();
+	while (!ZoneHead().compare_exchange_weak(Next, this)) {}
+}
+
+void Zone::Record(uint64_t Elapsed, Reading const &Counts)
+{
+	Calls.fetch_add(1, std::memory_order_relaxed);
+	Nanoseconds.fetch_add(Elapsed, std::memory_order_relaxed);
+	for (unsigned int Index = 0; Index < EventCount; Index++)
+		if (Counts.Has(static_cast<Event>(Index))) Values[Index].fetch_add(Counts.Values[Index], std::memory_order_relaxed);
+	if ((Valid.load(std::memory_order_relaxed) & Counts.Valid) != Counts.Valid) Valid.fetch_or(Counts.Valid, std::memory_order_relaxed);
+}
+
+void Zone::Reset(void)
+{
+	Calls.store(0, std::memory_order_relaxed);
+	Nanoseconds.store(0, std::memory_order_relaxed);
+	for (auto &Value : Values) Value.store(0, std::memory_order_relaxed);
+	Valid.store(0, std::memory_order_relaxed);
+}
+
+char const *Zone::GetName(void) const { return Name; }
+
+uint64_t Zone::GetCalls(void) const { return Calls.load(std::memory_order_relaxed); }
+
+uint64_t Zone::GetNanoseconds(void) const { return Nanoseconds.load(std::memory_order_relaxed); }
+
+Reading Zone::GetCounts(void) const
+{
+	Reading Out;
+	for (unsigned int Index = 0; Index < EventCount; Index++) Out.Values[Index] = Values[Index].load(std::memory_order_relaxed);
+	Out.Valid = Valid.load(std::memory_order_relaxed);
+	return Out;
+}
+
+Zone const *Zone::GetNext(void) const { return Next; }
+
+Zone const *Zone::GetFirst(void) { return ZoneHead().load(); }
+
+static uint64_t Now(void)
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+ProfileZone::ProfileZone(Zone &Target) : Target(Target), StartNanoseconds(Now()), Start(Read()) {}
+
+ProfileZone::~ProfileZone(void)
+{
+	Reading const End = Read();
+	Target.Record(Now() - StartNanoseconds, End - Start);
+}
+
+String DescribeZones(void)
+{
+	StringBuilder Out;
+	for (Zone const *Current = Zone::GetFirst(); Current != nullptr; Current = Current->GetNext())
+	{
+		uint64_t const Calls = Current->GetCalls();
+		if (Calls == 0) continue;
+		Out << Current->GetName() << ": " << static_cast<unsigned long>(Calls) << " calls, " <<
+			static_cast<double>(Current->GetNanoseconds()) / Calls << " ns/call";
+		Reading const Counts = Current->GetCounts();
+		for (unsigned int Index = 0; Index < EventCount; Index++)
+			if (Counts.Has(static_cast<Event>(Index)))
+				Out << ", " << static_cast<double>(Counts.Values[Index]) / Calls << " " << Counters::GetName(static_cast<Event>(Index)) << "/call";
+		Out << "\n";
+	}
+	return Out;
+}
+
+void LogZones(AnnalsBase &Out, int Level)
+{
+	String const Description = DescribeZones();
+	if (Description.empty()) return;
+	Out.Log(Level, "Profile zones", Description.substr(0, Description.size() - 1));
+}
+
+}
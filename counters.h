@@ -0,0 +1,116 @@
+#ifndef counters_h
+#define counters_h
+
+#include <atomic>
+#include <cstdint>
+
+#include "string.h"
+#include "annals.h"
+
+/*
+Hardware performance counters for the calling thread, through perf_event on Linux.
+
+	static Counters::Zone WalkZone("asset walk");
+	...
+	{
+		Counters::ProfileZone Measure(WalkZone);
+		Assets.Walk(Load);
+	}
+	...
+	Counters::LogZones(GeneralAnnals());
+
+Each thread opens its own counters on first use and closes them when it exits.  Where counters
+can't be opened (other platforms, containers without a PMU, perf_event_paranoid) readings are
+marked invalid and zones still record calls and wall time.  Events the kernel multiplexes are
+scaled up by the fraction of time they were counting.
+*/
+
+namespace Counters
+{
+
+enum Event
+{
+	Cycles,
+	Instructions,
+	CacheMisses,
+	BranchMisses,
+	EventCount
+};
+
+char const *GetName(Event Named);
+
+struct Reading
+{
+	Reading(void);
+	bool Has(Event Checked) const { return (Valid & (1u << Checked)) != 0; }
+	Reading operator -(Reading const &Start) const;
+	Reading &operator +=(Reading const &Other);
+
+	uint64_t Values[EventCount];
+	unsigned int Valid; // Bit per Event
+};
+
+bool IsAvailable(void); // Whether any counter opened on this thread
+Reading Read(void); // Totals since this thread's counters were opened
+
+// Adds the counts over its lifetime to Total
+class Scope
+{
+	public:
+		Scope(Reading &Total);
+		~Scope(void);
+		Scope(Scope const &Other) = delete;
+		Scope &operator =(Scope const &Other) = delete;
+	private:
+		Reading &Total;
+		Reading Start;
+};
+
+// Accumulates calls, wall time and counts from any thread.  Zones must have static storage
+// duration; they register themselves for LogZones.
+class Zone
+{
+	public:
+		Zone(char const *Name);
+		Zone(Zone const &Other) = delete;
+		Zone &operator =(Zone const &Other) = delete;
+
+		void Record(uint64_t Nanoseconds, Reading const &Counts);
+		void Reset(void);
+
+		char const *GetName(void) const;
+		uint64_t GetCalls(void) const;
+		uint64_t GetNanoseconds(void) const;
+		Reading GetCounts(void) const;
+
+		Zone const *GetNext(void) const; // In the order zones were constructed, newest first
+		static Zone const *GetFirst(void);
+
+	private:
+		char const *Name;
+		std::atomic<uint64_t> Calls, Nanoseconds;
+		std::atomic<uint64_t> Values[EventCount];
+		std::atomic<unsigned int> Valid;
+		Zone *Next;
+};
+
+class ProfileZone
+{
+	public:
+		ProfileZone(Zone &Target);
+		~ProfileZone(void);
+		ProfileZone(ProfileZone const &Other) = delete;
+		ProfileZone &operator =(ProfileZone const &Other) = delete;
+	private:
+		Zone &Target;
+		uint64_t StartNanoseconds;
+		Reading Start;
+};
+
+// One line per zone that has been entered
+String DescribeZones(void);
+void LogZones(AnnalsBase &Out, int Level = rlDefault);
+
+}
+
+#endif
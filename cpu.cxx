@@ -0,0 +1,89 @@
+#include "cpu.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace CPU
+{
+
+static Features Detect(void)
+{
+	Features Out;
+	std::memset(&Out, 0, sizeof(Out));
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	// The builtins also check that the OS saves the wider registers
+	__builtin_cpu_init();
+	Out.SSE2 = __builtin_cpu_supports("sse2");
+	Out.SSSE3 = __builtin_cpu_supports("ssse3");
+	Out.SSE41 = __builtin_cpu_supports("sse4.1");
+	Out.SSE42 = __builtin_cpu_supports("sse4.2");
+	Out.POPCNT = __builtin_cpu_supports("popcnt");
+	Out.AVX = __builtin_cpu_supports("avx");
+	Out.AVX2 = __builtin_cpu_supports("avx2");
+	Out.FMA = __builtin_cpu_supports("fma");
+	Out.BMI2 = __builtin_cpu_supports("bmi2");
+	Out.AVX512F = __builtin_cpu_supports("avx512f");
+	Out.AVX512BW = __builtin_cpu_supports("avx512bw");
+#endif
+	return Out;
+}
+
+Features const &GetFeatures(void)
+{
+	static Features const Detected = Detect();
+	return Detected;
+}
+
+Level GetBestLevel(void)
+{
+	Features const &Has = GetFeatures();
+	if (Has.AVX512F && Has.AVX512BW && Has.AVX2) return Level::AVX512;
+	if (Has.AVX2 && Has.AVX) return Level::AVX2;
+	if (Has.SSE42 && Has.SSE41 && Has.SSSE3) return Level::SSE42;
+	if (Has.SSE2) return Level::SSE2;
+	return Level::Scalar;
+}
+
+static Level Clamp(Level Requested)
+	{ return (Requested < GetBestLevel()) ? Requested : GetBestLevel(); }
+
+static Level Initial(void)
+{
+	char const *Override = getenv("RENGENERAL_CPU");
+	if (Override != nullptr)
+		for (unsigned int Index = 0; Index < LevelCount; Index++)
+			if (strcmp(Override, GetName(static_cast<Level>(Index))) == 0)
+				return Clamp(static_cast<Level>(Index));
+	return GetBestLevel();
+}
+
+static std::atomic<unsigned char> &Current(void)
+{
+	static std::atomic<unsigned char> Selected(static_cast<unsigned char>(Initial()));
+	return Selected;
+}
+
+Level GetLevel(void) { return static_cast<Level>(Current().load(std::memory_order_relaxed)); }
+
+Level Force(Level Forced)
+{
+	Level const Used = Clamp(Forced);
+	Current().store(static_cast<unsigned char>(Used), std::memory_order_relaxed);
+	return Used;
+}
+
+char const *GetName(Level Named)
+{
+	switch (Named)
+	{
+		case Level::Scalar: return "scalar";
+		case Level::SSE2: return "sse2";
+		case Level::SSE42: return "sse4.2";
+		case Level::AVX2: return "avx2";
+		case Level::AVX512: return "avx512";
+	}
+	return "unknown";
+}
+
+}
@@ -0,0 +1,43 @@
+#ifndef cpu_h
+#define cpu_h
+
+/*
+Runtime CPU feature detection.
+
+The library is built for the baseline instruction set, and code with faster paths for newer ones
+picks them at runtime from GetLevel.  The level is the best the processor and OS support, unless
+overridden with the RENGENERAL_CPU environment variable (scalar, sse2, sse4.2, avx2 or avx512)
+or Force.  Neither override can raise the level above what is supported.
+*/
+
+namespace CPU
+{
+
+struct Features
+{
+	bool SSE2, SSSE3, SSE41, SSE42, POPCNT, AVX, AVX2, FMA, BMI2, AVX512F, AVX512BW;
+};
+
+enum class Level : unsigned char
+{
+	Scalar,
+	SSE2,
+	SSE42, // With SSSE3 and SSE4.1
+	AVX2,
+	AVX512 // F and BW
+};
+unsigned int const LevelCount = 5;
+
+Features const &GetFeatures(void);
+Level GetBestLevel(void); // Supported by this machine
+Level GetLevel(void); // In use
+
+// For testing every path on one machine.  Returns the level actually used.  Not safe to call
+// while other threads are running dispatched code.
+Level Force(Level Forced);
+
+char const *GetName(Level Named);
+
+}
+
+#endif
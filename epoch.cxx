@@ -0,0 +1,91 @@
+#include "epoch.h"
+
+#include <thread>
+#include <functional>
+
+namespace Epoch
+{
+
+Domain::Domain(void) : GlobalEpoch(1)
+{
+	for (auto &Reader : Readers) Reader.Epoch.store(0, std::memory_order_relaxed);
+}
+
+Domain::~Domain(void)
+{
+#ifndef NDEBUG
+	for (auto &Reader : Readers) assert(Reader.Epoch.load() == 0);
+#endif
+	for (auto &Current : Retired) Current.Deleter(Current.Target);
+}
+
+void Domain::Retire(void *Target, void (*Deleter)(void *Retiree))
+{
+	std::lock_guard<std::mutex> Lock(RetiredMutex);
+	Retired.push_back(Retiree {Target, Deleter, GlobalEpoch.load(std::memory_order_seq_cst)});
+}
+
+void Domain::Collect(void)
+{
+	std::vector<Retiree> Freeable;
+	{
+		std::lock_guard<std::mutex> Lock(RetiredMutex);
+		if (Retired.empty()) return;
+
+		GlobalEpoch.fetch_add(1, std::memory_order_seq_cst);
+		uint64_t Oldest = UINT64_MAX;
+		for (auto &Reader : Readers)
+		{
+			uint64_t Entered = Reader.Epoch.load(std::memory_order_seq_cst);
+			if ((Entered != 0) && (Entered < Oldest)) Oldest = Entered;
+		}
+
+		// Anything retired before the oldest reader entered was already unreachable to it
+		auto Keep = Retired.begin();
+		for (auto &Current : Retired)
+		{
+			if (Current.Epoch < Oldest) Freeable.push_back(Current);
+			else *Keep++ = Current;
+		}
+		Retired.erase(Keep, Retired.end());
+	}
+	for (auto &Current : Freeable) Current.Deleter(Current.Target);
+}
+
+unsigned int Domain::Enter(void)
+{
+	// Start searching at a per-thread position so threads rarely compete for a slot
+	unsigned int const Start = std::hash<std::thread::id>()(std::this_thread::get_id()) % SlotCount;
+	while (true)
+	{
+		for (unsigned int Offset = 0; Offset < SlotCount; Offset++)
+		{
+			unsigned int const Slot = (Start + Offset) % SlotCount;
+			uint64_t Free = 0;
+			uint64_t Epoch = GlobalEpoch.load(std::memory_order_seq_cst);
+			if (!Readers[Slot].Epoch.compare_exchange_strong(Free, Epoch, std::memory_order_seq_cst))
+				continue;
+
+			// Republish until the epoch is stable, so a concurrent Collect can't miss this reader
+			uint64_t Current;
+			while ((Current = GlobalEpoch.load(std::memory_order_seq_cst)) != Epoch)
+			{
+				Epoch = Current;
+				Readers[Slot].Epoch.store(Epoch, std::memory_order_seq_cst);
+			}
+			return Slot;
+		}
+		std::this_thread::yield();
+	}
+}
+
+void Domain::Exit(unsigned int Slot)
+	{ Readers[Slot].Epoch.store(0, std::memory_order_release); }
+
+Domain &GeneralDomain(void)
+{
+	static Domain GeneralDomainInstance;
+	return GeneralDomainInstance;
+}
+
+}
@@ -0,0 +1,322 @@
+#ifndef epoch_h
+#define epoch_h
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+#include "factory.h"
+#include "club.h"
+#include "lifetime.h"
+
+/*
+Epoch-based reclamation lets reader threads walk shared collections without locking while a
+writer removes members.
+
+Readers hold a Guard for as long as they look at the collection.  Removed objects are retired
+to the domain rather than deleted, and Collect only frees objects retired before every current
+reader entered.  Readers never block; writers never wait for readers, they just free later.
+
+EpochFactory, EpochCleaner and EpochClub mirror Factory, Cleaner and Club.  Only one thread may
+modify each collection, but any number may read it.
+*/
+
+namespace Epoch
+{
+
+class Domain
+{
+	public:
+		Domain(void);
+		~Domain(void); // Frees everything retired, so no readers may remain
+		Domain(Domain const &Other) = delete;
+		Domain &operator =(Domain const &Other) = delete;
+
+		void Retire(void *Retiree, void (*Deleter)(void *Retiree));
+		template <typename Type> void Retire(Type *Retiree)
+			{ Retire(Retiree, [](void *Erased) { delete static_cast<Type *>(Erased); }); }
+
+		// Frees retired objects that no reader can still see
+		void Collect(void);
+
+	private:
+		friend class Guard;
+		static unsigned int const SlotCount = 128;
+
+		unsigned int Enter(void);
+		void Exit(unsigned int Slot);
+
+		// 0 is a free slot, otherwise the epoch the reader entered in
+		struct alignas(64) ReaderSlot { std::atomic<uint64_t> Epoch; };
+		ReaderSlot Readers[SlotCount];
+		std::atomic<uint64_t> GlobalEpoch;
+
+		struct Retiree { void *Target; void (*Deleter)(void *Retiree); uint64_t Epoch; };
+		std::mutex RetiredMutex;
+		std::vector<Retiree> Retired;
+};
+
+Domain &GeneralDomain(void);
+
+class Guard
+{
+	public:
+		Guard(Domain &Owner = GeneralDomain()) : Owner(Owner), Slot(Owner.Enter()) {}
+		~Guard(void) { Owner.Exit(Slot); }
+		Guard(Guard const &Other) = delete;
+		Guard &operator =(Guard const &Other) = delete;
+	private:
+		Domain &Owner;
+		unsigned int Slot;
+};
+
+// A singly linked list that one thread modifies while others read it under a Guard.  Removed
+// nodes stay intact until collection, so readers standing on one can continue their walk.
+template <typename Type> class List
+{
+	private:
+		struct Node
+		{
+			Node(Type *Value) : Value(Value), Next(nullptr) {}
+			Type *const Value;
+			std::atomic<Node *> Next;
+		};
+
+	public:
+		class Iterator
+		{
+			public:
+				Iterator(Node *Position) : Position(Position) {}
+				void operator++(void) { Position = Position->Next.load(std::memory_order_acquire); }
+				bool operator!=(Iterator const &Other) const { return Position != Other.Position; }
+				Type *operator*(void) const { return Position->Value; }
+			private:
+				Node *Position;
+		};
+
+		List(Domain &Owner) : Owner(Owner), Head(nullptr), Tail(nullptr), Count(0) {}
+
+		~List(void)
+		{
+			for (Node *Current = Head.load(std::memory_order_relaxed); Current != nullptr; )
+			{
+				Node *Next = Current->Next.load(std::memory_order_relaxed);
+				delete Current;
+				Current = Next;
+			}
+		}
+
+		// Reading
+		Iterator begin(void) const { return Iterator(Head.load(std::memory_order_acquire)); }
+		Iterator end(void) const { return Iterator(nullptr); }
+
+		// Writing
+		void PushFront(Type *Value)
+		{
+			Node *Created = new Node(Value);
+			Created->Next.store(Head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			Head.store(Created, std::memory_order_release);
+			if (Tail == nullptr) Tail = Created;
+			Count++;
+		}
+
+		void PushBack(Type *Value)
+		{
+			Node *Created = new Node(Value);
+			if (Tail == nullptr) Head.store(Created, std::memory_order_release);
+			else Tail->Next.store(Created, std::memory_order_release);
+			Tail = Created;
+			Count++;
+		}
+
+		// Unlinks values matching Predicate and retires them along with their nodes.  Dispose
+		// runs once no reader can see the value.
+		template <typename PredicateType> void RemoveIf(PredicateType const &Predicate, void (*Dispose)(void *Value))
+		{
+			Node *Previous = nullptr;
+			for (Node *Current = Head.load(std::memory_order_relaxed); Current != nullptr; )
+			{
+				Node *Next = Current->Next.load(std::memory_order_relaxed);
+				if (!Predicate(Current->Value))
+				{
+					Previous = Current;
+					Current = Next;
+					continue;
+				}
+
+				if (Previous == nullptr) Head.store(Next, std::memory_order_release);
+				else Previous->Next.store(Next, std::memory_order_release);
+				if (Tail == Current) Tail = Previous;
+				Count--;
+
+				if (Dispose != nullptr) Owner.Retire(Current->Value, Dispose);
+				Owner.Retire(Current);
+				Current = Next;
+			}
+		}
+
+		size_t Size(void) const { return Count; }
+		bool Empty(void) const { return Count == 0; }
+
+	private:
+		Domain &Owner;
+		std::atomic<Node *> Head;
+		Node *Tail;
+		size_t Count;
+};
+
+}
+
+// ========================================================================
+// Reclaiming counterparts of Factory, Cleaner and Club
+
+template <class Type> class EpochFactory
+{
+	public:
+		EpochFactory(bool ShouldCheckOnDestruct, Epoch::Domain &Owner = Epoch::GeneralDomain()) :
+			CheckOnDestruct(ShouldCheckOnDestruct), Owner(Owner), Items(Owner)
+			{}
+
+		~EpochFactory(void)
+		{
+			for (auto Item : Items)
+			{
+				if (CheckOnDestruct) assert(Item->ShouldBeDeleted());
+				delete Item;
+			}
+		}
+
+		void AddItem(Type *ToBeManaged) { Items.PushFront(ToBeManaged); }
+
+		void Clean(void)
+		{
+			Items.RemoveIf([](Type *Item) { return Item->ShouldBeDeleted(); },
+				[](void *Item) { delete static_cast<Type *>(Item); });
+			Owner.Collect();
+		}
+
+		// Iterate only while holding an Epoch::Guard on the factory's domain
+		typename Epoch::List<Type>::Iterator begin(void) const { return Items.begin(); }
+		typename Epoch::List<Type>::Iterator end(void) const { return Items.end(); }
+
+		template <typename VisitorType> void Read(VisitorType const &Visit) const
+		{
+			Epoch::Guard Reading(Owner);
+			for (auto Item : Items) Visit(Item);
+		}
+
+	protected:
+		bool CheckOnDestruct;
+		Epoch::Domain &Owner;
+		Epoch::List<Type> Items;
+};
+
+// BaseType must derive from Cleaner<BaseType>::Item
+template <class BaseType> class EpochCleaner
+{
+	public:
+		EpochCleaner(bool Warn = false, Epoch::Domain &Owner = Epoch::GeneralDomain()) :
+			Warn(Warn), Owner(Owner), Items(Owner)
+			{}
+
+		virtual ~EpochCleaner(void)
+		{
+			for (auto Item : Items)
+			{
+				assert(!(Warn && Item->HasExpired()));
+				delete Item;
+			}
+		}
+
+		void push_back(BaseType *Item) { Items.PushBack(Item); }
+		size_t size(void) const { return Items.Size(); }
+		bool empty(void) const { return Items.Empty(); }
+
+		void Purge(void)
+		{
+			Items.RemoveIf([](BaseType *Item) { return Item->HasExpired(); },
+				[](void *Item) { delete static_cast<BaseType *>(Item); });
+			Owner.Collect();
+		}
+
+		void Update(void)
+		{
+			for (auto Item : Items) if (!Item->HasExpired()) UpdateItem(Item);
+			Purge();
+		}
+
+		// Iterate only while holding an Epoch::Guard on the cleaner's domain
+		typename Epoch::List<BaseType>::Iterator begin(void) const { return Items.begin(); }
+		typename Epoch::List<BaseType>::Iterator end(void) const { return Items.end(); }
+
+		template <typename VisitorType> void Read(VisitorType const &Visit) const
+		{
+			Epoch::Guard Reading(Owner);
+			for (auto Item : Items) Visit(Item);
+		}
+
+	protected:
+		virtual void UpdateItem(BaseType *Item) {}
+	private:
+		bool Warn;
+		Epoch::Domain &Owner;
+		Epoch::List<BaseType> Items;
+};
+
+// Like Club, this doesn't manage member lifespans; only the membership records are reclaimed.
+template <class MemberType> class EpochClub
+{
+	public:
+		EpochClub(Epoch::Domain &Owner = Epoch::GeneralDomain()) : Owner(Owner), Members(Owner) {}
+
+		virtual ~EpochClub(void)
+		{
+			for (auto Record : Members)
+			{
+				assert(!Record->first);
+				Accounting::Refund(Accounting::Tags::Club(), sizeof(std::pair<bool, MemberType *>));
+				delete Record;
+			}
+		}
+
+		void Register(MemberType *Inductee)
+		{
+			auto Record = new std::pair<bool, MemberType *>(true, Inductee);
+			Accounting::Charge(Accounting::Tags::Club(), sizeof(std::pair<bool, MemberType *>));
+			Members.PushBack(Record);
+			static_cast<Member<MemberType> *>(Inductee)->Join(new Membership(Record->first));
+		}
+
+		void Clean(void)
+		{
+			Members.RemoveIf([](std::pair<bool, MemberType *> *Record) { return !Record->first; },
+				[](void *Record)
+				{
+					Accounting::Refund(Accounting::Tags::Club(), sizeof(std::pair<bool, MemberType *>));
+					delete static_cast<std::pair<bool, MemberType *> *>(Record);
+				});
+			Owner.Collect();
+		}
+
+		bool Empty(void) const { return Members.Empty(); }
+
+		// Records of members, which may have left since the last Clean.  Iterate only while
+		// holding an Epoch::Guard on the club's domain.
+		typedef typename Epoch::List<std::pair<bool, MemberType *> >::Iterator Iterator;
+		Iterator Begin(void) const { return Members.begin(); }
+		Iterator End(void) const { return Members.end(); }
+
+		template <typename VisitorType> void Read(VisitorType const &Visit) const
+		{
+			Epoch::Guard Reading(Owner);
+			for (auto Record : Members) Visit(Record->second);
+		}
+
+	protected:
+		Epoch::Domain &Owner;
+		Epoch::List<std::pair<bool, MemberType *> > Members;
+};
+
+#endif
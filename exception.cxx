@@ -1,5 +1,8 @@
 #include "exception.h"
 
+#include <cerrno>
+#include <cstring>
+
 namespace Error
 {
 
@@ -15,4 +18,45 @@ System::System(String const &Explanation) :
 	Explanation(Explanation)
 	{}
 
+Status::Status(void) : Reason(Code::None), SystemError(0), Detail(nullptr) {}
+
+Status::Status(Code Reason, char const *Detail, int SystemError) :
+	Reason(Reason), SystemError(SystemError), Detail(Detail)
+	{}
+
+Status Status::FromSystem(char const *Detail, int SystemError)
+{
+	switch (SystemError)
+	{
+		case ENOENT: case ENOTDIR: return Status(Code::Missing, Detail, SystemError);
+		case EACCES: case EPERM: case EROFS: return Status(Code::Denied, Detail, SystemError);
+		case EEXIST: return Status(Code::Exists, Detail, SystemError);
+		case EINVAL: case ENAMETOOLONG: return Status(Code::Invalid, Detail, SystemError);
+		default: return Status(Code::System, Detail, SystemError);
+	}
+}
+
+Status::operator bool(void) const { return Reason == Code::None; }
+
+Code Status::GetCode(void) const { return Reason; }
+
+char const *Status::GetDetail(void) const { return Detail; }
+
+int Status::GetSystemError(void) const { return SystemError; }
+
+String Status::Message(void) const
+{
+	if (Reason == Code::None) return String();
+	String Out = Detail == nullptr ? "Unknown error" : Detail;
+	if (SystemError != 0) { Out += ": "; Out += strerror(SystemError); }
+	return Out;
+}
+
+void Status::Throw(void) const
+{
+	assert(Reason != Code::None);
+	if (Reason == Code::Invalid) throw Construction(Message());
+	throw System(Message());
+}
+
 }
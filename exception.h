@@ -1,6 +1,10 @@
 #ifndef exception_h
 #define exception_h
 
+#include <new>
+#include <utility>
+#include <cassert>
+
 #include "string.h"
 
 namespace Error
@@ -30,6 +34,63 @@ class System
 		String Explanation;
 };
 
+enum class Code : unsigned char
+{
+	None,
+	Invalid, // Malformed input, such as a relative path where an absolute one was needed
+	Missing,
+	Denied,
+	Exists,
+	System // Any other system failure; see the error number
+};
+
+class Status
+{
+	/// A failure reported without throwing.  Holds only a code, a static description and the system error number, so failing costs no allocations; the full message is built if asked for.
+	public:
+		Status(void); // Success
+		Status(Code Reason, char const *Detail, int SystemError = 0);
+		static Status FromSystem(char const *Detail, int SystemError); // Picks the code for an errno value
+
+		explicit operator bool(void) const; // True on success
+		Code GetCode(void) const;
+		char const *GetDetail(void) const;
+		int GetSystemError(void) const;
+
+		String Message(void) const;
+		void Throw(void) const; // Throws Construction for invalid input, System otherwise
+	private:
+		Code Reason;
+		int SystemError;
+		char const *Detail;
+};
+
+template <typename ValueType> class Result
+{
+	/// Either a value or the Status explaining why there isn't one.
+	public:
+		Result(ValueType &&Value) { new (&this->Value) ValueType(std::move(Value)); }
+		Result(ValueType const &Value) { new (&this->Value) ValueType(Value); }
+		Result(Status const &Failure) : Failure(Failure) { assert(!Failure); }
+		Result(Result &&Other) : Failure(Other.Failure)
+			{ if (Failure) new (&Value) ValueType(std::move(Other.Value)); }
+		Result(Result const &Other) = delete;
+		Result &operator =(Result const &Other) = delete;
+		~Result(void) { if (Failure) Value.~ValueType(); }
+
+		explicit operator bool(void) const { return static_cast<bool>(Failure); }
+		Status const &GetStatus(void) const { return Failure; }
+
+		ValueType &operator *(void) { assert(Failure); return Value; }
+		ValueType *operator ->(void) { assert(Failure); return &Value; }
+
+		// Throws as the throwing overload would have
+		ValueType &Get(void) { if (!Failure) Failure.Throw(); return Value; }
+	private:
+		Status Failure;
+		union { ValueType Value; };
+};
+
 }
 
 #endif
@@ -5,6 +5,8 @@
 #include <cassert>
 #include <iostream>
 
+#include "accounting.h"
+
 /*
 The scope of the managed objects is controlled by the factory.
 
@@ -27,12 +29,13 @@ template <class Type> class Factory
 				CurrentItem != Items.end(); CurrentItem++)
 			{
 				if (CheckOnDestruct) assert((*CurrentItem)->ShouldBeDeleted());
+				Accounting::Refund(Accounting::Tags::Factory(), sizeof(Type));
 				delete *CurrentItem;
 			}
 		}
 
 		void AddItem(Type *ToBeManaged)
-			{ Items.push_front(ToBeManaged); }
+			{ Accounting::Charge(Accounting::Tags::Factory(), sizeof(Type)); Items.push_front(ToBeManaged); }
 
 		/*void Prune(void)
 		{
@@ -61,6 +64,7 @@ template <class Type> class Factory
 				if (!(*CurrentItem)->ShouldBeDeleted()) CurrentItem++;
 				else
 				{
+					Accounting::Refund(Accounting::Tags::Factory(), sizeof(Type));
 					delete *CurrentItem;
 					DeleteItem = CurrentItem;
 					CurrentItem++;
@@ -149,6 +153,7 @@ template <class Type> class ActiveFactory : public Factory<Type>
 				}
 				else
 				{
+					Accounting::Refund(Accounting::Tags::Factory(), sizeof(Type));
 					delete *CurrentItem;
 					DeleteItem = CurrentItem;
 					CurrentItem++;
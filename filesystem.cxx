@@ -17,6 +17,7 @@
 
 #include "exception.h"
 #include "arrangement.h"
+#include "stringbuilder.h"
 
 // My policy on case insensitivity on Windows: pretend it doesn't exist.  If two paths with different cases are compared, subsetted, whatever, they will be considered inequivalent.
 
@@ -66,13 +67,13 @@ class PathStringIterator
 		size_t PreviousMarker, Marker;
 };
 
-Path::Path(String const &Absolute)
+Error::Status Path::Parse(String const &Absolute, PartCollection &Parts)
 {
 	if (Absolute.empty())
-		throw Error::Construction("Absolute paths must not be empty.");
+		return Error::Status(Error::Code::Invalid, "Absolute paths must not be empty.");
 
 	if (!IsAbsolute(Absolute))
-		throw Error::Construction("Base paths must be constructed with absolute paths.");
+		return Error::Status(Error::Code::Invalid, "Base paths must be constructed with absolute paths.");
 	
 	PathStringIterator AbsoluteIterator(Absolute);
 
@@ -83,9 +84,9 @@ Path::Path(String const &Absolute)
 			continue;
 		else if (Part == u8"..")
 		{
-			if (Parts.empty()) throw Error::Construction(".. directory specified at root level!");
+			if (Parts.empty()) return Error::Status(Error::Code::Invalid, ".. directory specified at root level!");
 #ifdef WINDOWS
-			if (Parts.size() == 1) throw Error::Construction(".. directory specified at root level!");
+			if (Parts.size() == 1) return Error::Status(Error::Code::Invalid, ".. directory specified at root level!");
 #endif
 			Parts.pop_back();
 		}
@@ -93,6 +94,13 @@ Path::Path(String const &Absolute)
 			continue;
 		else Parts.push_back(Part);
 	}
+	return Error::Status();
+}
+
+Path::Path(String const &Absolute)
+{
+	Error::Status Parsed = Parse(Absolute, Parts);
+	if (!Parsed) Parsed.Throw();
 }
 
 Path::Path(Path const &Other) : Parts(Other.Parts) {}
@@ -101,7 +109,13 @@ Path::~Path(void) {}
 
 String Path::AsAbsoluteString(char const *Separator) const
 {
-	MemoryStream Out;
+	StringBuilder Out;
+	AppendAbsoluteString(Out, Separator);
+	return Out;
+}
+
+void Path::AppendAbsoluteString(StringBuilder &Out, char const *Separator) const
+{
 #ifdef WINDOWS
 	bool First = true;
 #else
@@ -109,7 +123,7 @@ String Path::AsAbsoluteString(char const *Separator) const
 		Out << Separator;
 #endif
 
-	for (auto Part : Parts)
+	for (auto &Part : Parts)
 	{
 #ifdef WINDOWS
 		if (First) First = false;
@@ -124,7 +138,6 @@ String Path::AsAbsoluteString(char const *Separator) const
 	if (Parts.size() == 1)
 		Out << Separator;
 #endif
-	return Out;
 }
 
 Path::operator String(void) const
@@ -132,7 +145,7 @@ Path::operator String(void) const
 
 String Path::AsRelativeString(DirectoryPath const &From) const
 {
-	MemoryStream Out;
+	StringBuilder Out;
 	bool First = true;
 	auto AppendPart = [&Out, &First](String const &Part)
 	{
@@ -200,20 +213,28 @@ FilePath FilePath::Qualify(String const &RawPath)
 	return FilePath(LocateWorkingDirectory().AsAbsoluteString() + "/" + RawPath);
 }
 
+Error::Result<FilePath> FilePath::TryParse(String const &AbsolutePath)
+{
+	PartCollection Parts;
+	Error::Status Parsed = Parse(AbsolutePath, Parts);
+	if (!Parsed) return Parsed;
+	return FilePath(Parts);
+}
+
 String FilePath::File(void) const { return Parts.back(); }
 
 DirectoryPath FilePath::Directory(void) const { return DirectoryPath(PartCollection(Parts.begin(), --Parts.end())); }
-#include <iostream>
-#include <iomanip>
 bool FilePath::Exists(void) const
 {
+	StringBuilder Absolute;
+	AppendAbsoluteString(Absolute);
 #ifdef WINDOWS
 	//DWORD Attributes = GetFileAttributesW(reinterpret_cast<wchar_t const *>(AsNativeString("\\\\?\\" + AsAbsoluteString()).c_str())); // Doesn't work for some reason -- mixed slashes?
-	DWORD Attributes = GetFileAttributesW(reinterpret_cast<wchar_t const *>(AsNativeString(AsAbsoluteString()).c_str()));
-        return !Set<DWORD>({0xFFFFFFFF, 0x10}).Contains(Attributes);
+	DWORD Attributes = GetFileAttributesW(reinterpret_cast<wchar_t const *>(AsNativeString(Absolute).c_str()));
+        return !SmallSet<DWORD, 2>({0xFFFFFFFF, 0x10}).Contains(Attributes);
 #else
 	struct stat StatResultBuffer;
-	int Result = stat(AsAbsoluteString().c_str(), &StatResultBuffer);
+	int Result = stat(Absolute.CString(), &StatResultBuffer);
 	if (Result != 0) return false;
 	return S_ISREG(StatResultBuffer.st_mode);
 #endif
@@ -225,6 +246,20 @@ FileInput FilePath::Read(void) const
 FileOutput FilePath::Write(bool Append, bool Truncate) const
 	{ return FileOutput(AsAbsoluteString(), (Append ? FileOutput::Append : 0) | (Truncate ? FileOutput::Erase : 0)); }
 
+Error::Result<FileInput> FilePath::TryRead(void) const
+{
+	StringBuilder Absolute;
+	AppendAbsoluteString(Absolute);
+	return FileInput::TryOpen(Absolute.CString());
+}
+
+Error::Result<FileOutput> FilePath::TryWrite(bool Append, bool Truncate) const
+{
+	StringBuilder Absolute;
+	AppendAbsoluteString(Absolute);
+	return FileOutput::TryOpen(Absolute.CString(), (Append ? FileOutput::Append : 0) | (Truncate ? FileOutput::Erase : 0));
+}
+
 FilePath::operator FileInput(void) const { return Read(); }
 
 FilePath::operator FileOutput(void) const { return Write(); }
@@ -238,6 +273,8 @@ bool FilePath::Delete(void) const
 #endif
 }
 
+FilePath::FilePath(Path::PartCollection const &Parts) : Path(Parts) {}
+
 FilePath::FilePath(Path::PartCollection const &Parts, String const &Filename) : Path(Parts)
 	{ this->Parts.push_back(Filename); }
 
@@ -251,47 +288,65 @@ DirectoryPath DirectoryPath::Qualify(String const &RawPath)
 }
 
 DirectoryPath::DirectoryPath(String const &Absolute) : Path(Absolute) {}
+
+Error::Result<DirectoryPath> DirectoryPath::TryParse(String const &AbsolutePath)
+{
+	PartCollection Parts;
+	Error::Status Parsed = Parse(AbsolutePath, Parts);
+	if (!Parsed) return Parsed;
+	return DirectoryPath(Parts);
+}
 		
 bool DirectoryPath::Exists(void) const
 {
+	StringBuilder Absolute;
+	AppendAbsoluteString(Absolute);
 #ifdef WINDOWS
-        return GetFileAttributesW(reinterpret_cast<wchar_t const *>(AsNativeString("\\\\?\\" + AsAbsoluteString()).c_str())) & 0x10;
+        return GetFileAttributesW(reinterpret_cast<wchar_t const *>(AsNativeString("\\\\?\\" + Absolute.AsString()).c_str())) & 0x10;
 #else
 	struct stat StatResultBuffer;
-	int Result = stat(AsAbsoluteString().c_str(), &StatResultBuffer);
+	int Result = stat(Absolute.CString(), &StatResultBuffer);
 	if (Result != 0) return false;
 	return S_ISDIR(StatResultBuffer.st_mode);
 #endif
 }
 
 bool DirectoryPath::Create(bool EnsureAncestors) const
+	{ return static_cast<bool>(TryCreate(EnsureAncestors)); }
+
+Error::Status DirectoryPath::TryCreate(bool EnsureAncestors) const
 {
-	auto MakeSingleDirectory = [](DirectoryPath const &Ancestor) -> bool
+	StringBuilder Ancestor;
+	auto MakeSingleDirectory = [&Ancestor](void) -> Error::Status
 	{
 #ifdef WINDOWS
-		int Result = _wmkdir(reinterpret_cast<wchar_t const *>(AsNativeString(Ancestor.AsAbsoluteString()).c_str()));
+		int Result = _wmkdir(reinterpret_cast<wchar_t const *>(AsNativeString(Ancestor).c_str()));
 #else
-		int Result = mkdir(((String)Ancestor).c_str(), 0777);
+		int Result = mkdir(Ancestor.CString(), 0777);
 #endif
 		if (Result == -1 && errno != EEXIST)
-			return false;
-		return true;
+			return Error::Status::FromSystem("Couldn't create directory", errno);
+		return Error::Status();
 	};
 
 	if (EnsureAncestors)
 	{
-		DirectoryPath Ancestor;
 		for (Path::PartCollection::const_iterator CurrentPart = Parts.begin(); CurrentPart != Parts.end(); CurrentPart++)
 		{
-			Ancestor.Enter(*CurrentPart);
-			if (!MakeSingleDirectory(Ancestor))
-				return false;
+#ifdef WINDOWS
+			Ancestor << *CurrentPart << u8"/"; // The drive needs its slash
+#else
+			Ancestor << u8"/" << *CurrentPart;
+#endif
+			Error::Status Made = MakeSingleDirectory();
+			if (!Made) return Made;
 		}
-		return true;
+		return Error::Status();
 	}
 	else
 	{
-		return MakeSingleDirectory(*this);
+		AppendAbsoluteString(Ancestor);
+		return MakeSingleDirectory();
 	}
 }
 
@@ -321,7 +376,7 @@ static void ProcessDirectoryContents(DirectoryPath const &DirectoryName, std::fu
 	do
 	{
 		String FindName = AsString(NativeString(reinterpret_cast<char16_t const *>(ElementInfo.cFileName)));
-		if (Set<String>({".", ".."}).Contains(FindName)) continue;
+		if (SmallSet<String, 2>({".", ".."}).Contains(FindName)) continue;
 
 		Process(FindName, ElementInfo.dwFileAttributes & ~FILE_ATTRIBUTE_DIRECTORY);
 	} while (FindNextFileW(DirectoryResource, &ElementInfo) != 0);
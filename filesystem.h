@@ -9,6 +9,7 @@
 
 class Path;
 class DirectoryPath;
+class StringBuilder;
 class Path
 {
 	public:
@@ -17,6 +18,7 @@ class Path
 		virtual ~Path(void);
 
 		virtual String AsAbsoluteString(char const *Separator = u8"/") const;
+		void AppendAbsoluteString(StringBuilder &Out, char const *Separator = u8"/") const;
 		operator String(void) const;
 		//operator NativeString(void) const;
 
@@ -27,6 +29,7 @@ class Path
 	protected:
 		typedef std::list<String> PartCollection;
 
+		static Error::Status Parse(String const &Absolute, PartCollection &Parts);
 		Path(PartCollection const &Parts);
 		PartCollection FindCommonRoot(PartCollection const &OtherParts, PartCollection::const_iterator &LocalDivergence, PartCollection::const_iterator &OtherDivergence) const;
 
@@ -37,6 +40,7 @@ class FilePath : public Path
 {
 	public:
 		FilePath(String const &AbsolutePath);
+		static Error::Result<FilePath> TryParse(String const &AbsolutePath);
 		static FilePath Qualify(String const &RawPath);
 
 		String File(void) const;
@@ -46,12 +50,16 @@ class FilePath : public Path
 
 		FileInput Read(void) const;
 		FileOutput Write(bool Append = false, bool Truncate = false) const;
+		// As Read and Write, but failures are returned rather than thrown
+		Error::Result<FileInput> TryRead(void) const;
+		Error::Result<FileOutput> TryWrite(bool Append = false, bool Truncate = false) const;
 		operator FileInput(void) const;
 		operator FileOutput(void) const;
 
 		bool Delete(void) const;
 	private:
 		friend class DirectoryPath;
+		FilePath(Path::PartCollection const &Parts);
 		FilePath(Path::PartCollection const &Parts, String const &Filename);
 };
 
@@ -60,11 +68,13 @@ class DirectoryPath : public Path
 	public:
 		DirectoryPath(void);
 		DirectoryPath(String const &AbsolutePath);
+		static Error::Result<DirectoryPath> TryParse(String const &AbsolutePath);
 		static DirectoryPath Qualify(String const &RawPath);
 		
 		bool Exists(void) const;
 
 		bool Create(bool EnsureAncestors) const;
+		Error::Status TryCreate(bool EnsureAncestors) const;
 
 		DirectoryPath &Exit(void);
 		DirectoryPath &Enter(String const &Directory);
@@ -4,6 +4,8 @@
 #include <iomanip>
 #include <cassert>
 #include <cstring>
+#include <algorithm>
+#include <utility>
 
 #ifdef WINDOWS
 #include <wchar.h>
@@ -11,6 +13,10 @@
 #endif
 
 #include "filesystem.h"
+#include "batch.h"
+#include "accounting.h"
+
+static unsigned int const HexChunk = 256; // Bytes hex encoded per write
 
 OutputStream::~OutputStream(void) {}
 		
@@ -386,29 +392,48 @@ void StandardErrorStreamTag::CheckOutput(void)
 
 StandardErrorStreamTag StandardErrorStream;
 
-FileOutput::FileOutput(String const &Filename, unsigned int Mode) :
+static FILE *OpenOutputFile(char const *Filename, unsigned int Mode)
+{
 #ifdef WINDOWS
-	File(_wfopen(reinterpret_cast<wchar_t const *>(AsNativeString(Filename).c_str()), 
-		Mode & Erase ?
-			Mode & Append ? L"wab" :
+	return _wfopen(reinterpret_cast<wchar_t const *>(AsNativeString(Filename).c_str()), 
+		Mode & FileOutput::Erase ?
+			Mode & FileOutput::Append ? L"wab" :
 			L"wb" :
-		L"ab"))
+		L"ab");
 #else
-	File(fopen(Filename.c_str(),
-		Mode & Erase ?
-			Mode & Append ? "wa" :
+	return fopen(Filename,
+		Mode & FileOutput::Erase ?
+			Mode & FileOutput::Append ? "wa" :
 			"w" :
-		"a"))
+		"a");
 #endif
+}
+
+FileOutput::FileOutput(String const &Filename, unsigned int Mode) : File(OpenOutputFile(Filename.c_str(), Mode))
 {
 	if (File == nullptr) throw Error::System("Couldn't open file " + Filename);
 }
 
+Error::Result<FileOutput> FileOutput::TryOpen(char const *Filename, unsigned int Mode)
+{
+	FILE *Opened = OpenOutputFile(Filename, Mode);
+	if (Opened == nullptr) return Error::Status::FromSystem("Couldn't open file for writing", errno);
+	return FileOutput(Opened);
+}
+
+FileOutput::FileOutput(FILE *File) : File(File) {}
+
 FileOutput::FileOutput(FileOutput &&Other) : File(Other.File)
 	{ Other.File = nullptr; }
 
 FileOutput &FileOutput::operator =(FileOutput &&Other)
-	{ File = Other.File; Other.File = nullptr; return *this; }
+{
+	if (&Other == this) return *this;
+	if (File != nullptr) fclose(File);
+	File = Other.File;
+	Other.File = nullptr;
+	return *this;
+}
 
 FileOutput::~FileOutput(void)
 	{ if (File != nullptr) fclose(File); }
@@ -448,13 +473,15 @@ OutputStream &FileOutput::operator <<(String const &Data)
 
 OutputStream &FileOutput::operator <<(OutputStream::HexToken const &Data)
 {
-	int Result = 0;
-	for (unsigned int CurrentPosition = 0; CurrentPosition < Data.Length; CurrentPosition++)
+	CheckOutput();
+	char Digits[HexChunk * 2];
+	for (unsigned int Start = 0; Start < Data.Length; Start += HexChunk)
 	{
-		int NewResult = fprintf(stdout, "%02x", *((unsigned char *)Data.Data + CurrentPosition));
-		if ((NewResult < 0) && (Result >= 0)) Result = NewResult;
+		unsigned int const Length = std::min(HexChunk, Data.Length - Start);
+		Batch::Hex(static_cast<uint8_t const *>(Data.Data) + Start, Length, Digits);
+		size_t Result = fwrite(Digits, Length * 2, 1, File);
+		CheckWriteResult(Result);
 	}
-	CheckWriteResult(Result);
 	return *this;
 }
 
@@ -474,19 +501,41 @@ void FileOutput::CheckWriteResult(size_t Result)
 	}
 }
 
-FileInput::FileInput(String const &Filename) :
+static FILE *OpenInputFile(char const *Filename)
+{
 #ifdef WINDOWS
-	File(_wfopen(reinterpret_cast<wchar_t const *>(AsNativeString(Filename).c_str()), L"rb"))
+	return _wfopen(reinterpret_cast<wchar_t const *>(AsNativeString(Filename).c_str()), L"rb");
 #else
-	File(fopen(Filename.c_str(), "rb"))
+	return fopen(Filename, "rb");
 #endif
+}
+
+FileInput::FileInput(String const &Filename) : File(OpenInputFile(Filename.c_str()))
 	{ if (File == nullptr) throw Error::System("Couldn't open file " + Filename); }
 
-FileInput::FileInput(FileInput &&Other)
+Error::Result<FileInput> FileInput::TryOpen(char const *Filename)
+{
+	FILE *Opened = OpenInputFile(Filename);
+	if (Opened == nullptr) return Error::Status::FromSystem("Couldn't open file for reading", errno);
+	return FileInput(Opened);
+}
+
+FileInput::FileInput(FILE *File) : File(File) {}
+
+FileInput::FileInput(FileInput &&Other) : File(Other.File)
 	{ Other.File = nullptr; }
 		
 FileInput &FileInput::operator =(FileInput &&Other)
-	{ File = Other.File; Other.File = nullptr; return *this; }
+{
+	if (&Other == this) return *this;
+	if (File != nullptr) fclose(File);
+	File = Other.File;
+	Other.File = nullptr;
+	return *this;
+}
+
+FileInput::~FileInput(void)
+	{ if (File != nullptr) fclose(File); }
 
 InputStream &FileInput::operator >>(InputStream::RawToken &Data)
 { 
@@ -537,49 +586,84 @@ InputStream &FileInput::operator >>(String &Data)
 		
 FileInput::operator bool(void) const { return !feof(File) && !ferror(File); }
 
-MemoryStream::MemoryStream(unsigned int Reserve) { Buffer.str().reserve(Reserve); }
+MemoryStream::MemoryStream(unsigned int Reserve) : Accounted(0) { Buffer.str().reserve(Reserve); }
+
+MemoryStream::MemoryStream(String const &InitialData) : Buffer(InitialData), Accounted(InitialData.size())
+	{ Accounting::Charge(Accounting::Tags::Stream(), Accounted, (Accounted > 0) ? 1 : 0); }
 
-MemoryStream::MemoryStream(String const &InitialData) : Buffer(InitialData) {}
+MemoryStream::MemoryStream(MemoryStream &&Other) : Buffer(std::move(Other.Buffer)), Accounted(Other.Accounted)
+	{ Other.Accounted = 0; }
+
+MemoryStream &MemoryStream::operator =(MemoryStream &&Other)
+{
+	if (&Other == this) return *this;
+	Accounting::Refund(Accounting::Tags::Stream(), Accounted, (Accounted > 0) ? 1 : 0);
+	Buffer = std::move(Other.Buffer);
+	Accounted = Other.Accounted;
+	Other.Accounted = 0;
+	return *this;
+}
+
+MemoryStream::~MemoryStream(void) { Accounting::Refund(Accounting::Tags::Stream(), Accounted, (Accounted > 0) ? 1 : 0); }
+
+OutputStream &MemoryStream::Recount(void)
+{
+#ifdef RENGENERAL_MEMORY_ACCOUNTING
+	// Charges growth in the written contents; the buffer's spare capacity isn't visible.  Each
+	// stream counts as one allocation.
+	std::streamoff const Written = Buffer.tellp();
+	if ((Written > 0) && (static_cast<size_t>(Written) > Accounted))
+	{
+		Accounting::Charge(Accounting::Tags::Stream(), static_cast<size_t>(Written) - Accounted, (Accounted == 0) ? 1 : 0);
+		Accounted = static_cast<size_t>(Written);
+	}
+#endif
+	return *this;
+}
 
 OutputStream &MemoryStream::operator <<(OutputStream::FlushToken const &)
-	{ Buffer << std::flush; return *this; }
+	{ Buffer << std::flush; return Recount(); }
 
 OutputStream &MemoryStream::operator <<(OutputStream::RawToken const &Data)
-	{ Buffer.write((char const *)Data.Data, Data.Length); return *this; }
+	{ Buffer.write((char const *)Data.Data, Data.Length); return Recount(); }
 
 OutputStream &MemoryStream::operator <<(char const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 
 /*OutputStream &MemoryStream::operator <<(bool const &Data)
 	{ Buffer << Data; return *this; }*/
 
 OutputStream &MemoryStream::operator <<(int const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 
 OutputStream &MemoryStream::operator <<(long int const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 
 OutputStream &MemoryStream::operator <<(long unsigned int const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 
 OutputStream &MemoryStream::operator <<(unsigned int const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 
 OutputStream &MemoryStream::operator <<(float const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 
 OutputStream &MemoryStream::operator <<(double const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 		
 OutputStream &MemoryStream::operator <<(String const &Data)
-	{ Buffer << Data; return *this; }
+	{ Buffer << Data; return Recount(); }
 
 OutputStream &MemoryStream::operator <<(OutputStream::HexToken const &Data)
 {
-	Buffer << std::setfill('0');
-	for (unsigned int CurrentPosition = 0; CurrentPosition < Data.Length; CurrentPosition++)
-		Buffer << std::setw(2) << std::hex << static_cast<int>(((uint8_t *)Data.Data)[CurrentPosition]); 
-	return *this;
+	char Digits[HexChunk * 2];
+	for (unsigned int Start = 0; Start < Data.Length; Start += HexChunk)
+	{
+		unsigned int const Length = std::min(HexChunk, Data.Length - Start);
+		Batch::Hex(static_cast<uint8_t const *>(Data.Data) + Start, Length, Digits);
+		Buffer.write(Digits, Length * 2);
+	}
+	return Recount();
 }
 
 MemoryStream::operator String(void) const 
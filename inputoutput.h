@@ -175,6 +175,7 @@ class FileOutput : public OutputStream
 			Append = 1 << 1 
 		};
 		FileOutput(String const &Filename, unsigned int Mode = 0);
+		static Error::Result<FileOutput> TryOpen(char const *Filename, unsigned int Mode = 0);
 		FileOutput(FileOutput &&Other);
 		FileOutput &operator =(FileOutput &&Other);
 		~FileOutput(void);
@@ -193,6 +194,7 @@ class FileOutput : public OutputStream
 		OutputStream &operator <<(String const &Data);
 		OutputStream &operator <<(OutputStream::HexToken const &Data);
 	private:
+		explicit FileOutput(FILE *File);
 		void CheckOutput(void);
 		void CheckWriteResult(size_t Result);
 
@@ -205,12 +207,15 @@ class FileInput : public InputStream
 		using InputStream::operator >>;
 
 		FileInput(String const &Filename);
+		static Error::Result<FileInput> TryOpen(char const *Filename);
 		FileInput(FileInput &&Other);
 		FileInput &operator =(FileInput &&Other);
+		~FileInput(void);
 		InputStream &operator >>(InputStream::RawToken &Data);
 		InputStream &operator >>(String &Data);
 		operator bool(void) const;
 	private:
+		explicit FileInput(FILE *File);
 		void CheckInput(void);
 		void CheckReadResult(size_t Result);
 		FILE *File;
@@ -224,6 +229,9 @@ class MemoryStream : public OutputStream, public InputStream
 		
 		MemoryStream(unsigned int Reserve = 0);
 		MemoryStream(String const &InitialData);
+		MemoryStream(MemoryStream &&Other);
+		MemoryStream &operator =(MemoryStream &&Other);
+		~MemoryStream(void);
 		OutputStream &operator <<(OutputStream::FlushToken const &Data);
 		OutputStream &operator <<(OutputStream::RawToken const &Data);
 		OutputStream &operator <<(char const &Data);
@@ -243,7 +251,9 @@ class MemoryStream : public OutputStream, public InputStream
 		InputStream &operator >>(String &Data); // Reads a line
 		operator bool(void) const;
 	private:
+		OutputStream &Recount(void);
 		std::stringstream Buffer;
+		size_t Accounted; // Bytes charged to Accounting::Tags::Stream
 };
 
 template <typename Base> String AsString(const Base &Convertee)
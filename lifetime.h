@@ -2,7 +2,12 @@
 #define lifetime_h
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
 #include <vector>
 #include <list>
 #include <set>
@@ -14,6 +19,8 @@
 
 #include <iostream>
 
+#include "accounting.h"
+
 template <class Type> class Anchor
 {
 	private:
@@ -35,12 +42,35 @@ template <class Type> class Anchor
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 /////////////////////////////////// Deleter - deletes members
-template <class Type, template<class Retype, class = std::allocator<Retype> > class Container> class DeleterBase : public Container<Type *>
+// Charges the deleter memory tag for the members a container owns.  Adding through the container's
+// insert, push and emplace methods counts straight away; members added any other way (assigning
+// through [], resize) are counted at the next erase, clear or pop.  Only sizeof(Type) is counted.
+template <class Type> class DeleterAccount
+{
+	protected:
+		DeleterAccount(void) : Accounted(0) {}
+		DeleterAccount(DeleterAccount const &) : Accounted(0) {}
+		DeleterAccount &operator =(DeleterAccount const &) { return *this; }
+		~DeleterAccount(void) { Accounting::Refund(Accounting::Tags::Deleter(), Accounted * sizeof(Type), Accounted); }
+
+		void Recount(size_t Count)
+		{
+			if (Count > Accounted) Accounting::Charge(Accounting::Tags::Deleter(), (Count - Accounted) * sizeof(Type), Count - Accounted);
+			else if (Count < Accounted) Accounting::Refund(Accounting::Tags::Deleter(), (Accounted - Count) * sizeof(Type), Accounted - Count);
+			Accounted = Count;
+		}
+
+	private:
+		size_t Accounted;
+};
+
+template <class Type, template<class Retype, class = std::allocator<Retype> > class Container> class DeleterBase :
+	public Container<Type *>, private DeleterAccount<Type>
 {
 	public:
 		DeleterBase(void) {}
 
-		DeleterBase(std::initializer_list<Type *> &&Elements) : Container<Type *>(Elements) {}
+		DeleterBase(std::initializer_list<Type *> &&Elements) : Container<Type *>(Elements) { Recount(); }
 
 		~DeleterBase(void)
 		{
@@ -49,23 +79,44 @@ template <class Type, template<class Retype, class = std::allocator<Retype> > cl
 				delete *CurrentElement;
 		}
 
+		template <typename ...ArgumentTypes> void push_back(ArgumentTypes &&...Arguments)
+			{ Container<Type *>::push_back(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> void push_front(ArgumentTypes &&...Arguments)
+			{ Container<Type *>::push_front(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> void emplace_back(ArgumentTypes &&...Arguments)
+			{ Container<Type *>::emplace_back(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> auto insert(ArgumentTypes &&...Arguments) ->
+			decltype(std::declval<Container<Type *> &>().insert(std::forward<ArgumentTypes>(Arguments)...))
+		{
+			auto Out = Container<Type *>::insert(std::forward<ArgumentTypes>(Arguments)...);
+			Recount();
+			return Out;
+		}
+
 		void clear(void)
 		{
 			for (typename Container<Type *>::iterator CurrentElement = Container<Type *>::begin();
 				CurrentElement != Container<Type *>::end(); CurrentElement++)
 				delete *CurrentElement;
 			Container<Type *>::clear();
+			Recount();
 		}
 
 		void flush(void)
 		{
 			Container<Type *>::clear();
+			Recount();
 		}
 
 		typename Container<Type *>::iterator erase(typename Container<Type *>::iterator Value)
 		{
 			delete *Value;
-			return Container<Type *>::erase(Value);
+			typename Container<Type *>::iterator Out = Container<Type *>::erase(Value);
+			Recount();
+			return Out;
 		}
 
 		bool erase(Type *Value)
@@ -76,6 +127,7 @@ template <class Type, template<class Retype, class = std::allocator<Retype> > cl
 			{
 				delete *Found;
 				Container<Type *>::erase(Found);
+				Recount();
 				return true;
 			}
 			else return false;
@@ -97,15 +149,18 @@ template <class Type, template<class Retype, class = std::allocator<Retype> > cl
 			}
 			else return false;
 		}*/
+
+	private:
+		void Recount(void) { DeleterAccount<Type>::Recount(Container<Type *>::size()); }
 };
 
 template <class Type> using DeleterList = DeleterBase<Type, std::list>;
 template <class Type> using DeleterVector = DeleterBase<Type, std::vector>;
 
-template <class Type> class DeleterSet : public std::set<Type *, std::less<Type *>, std::allocator<Type> >
+template <class Type> class DeleterSet : public std::set<Type *, std::less<Type *>, std::allocator<Type *> >, private DeleterAccount<Type>
 {
 	public:
-		typedef std::set<Type *, std::less<Type *>, std::allocator<Type> > Container;
+		typedef std::set<Type *, std::less<Type *>, std::allocator<Type *> > Container;
 
 		~DeleterSet(void)
 		{
@@ -114,18 +169,37 @@ template <class Type> class DeleterSet : public std::set<Type *, std::less<Type
 				delete *CurrentElement;
 		}
 
+		template <typename ...ArgumentTypes> auto insert(ArgumentTypes &&...Arguments) ->
+			decltype(std::declval<Container &>().insert(std::forward<ArgumentTypes>(Arguments)...))
+		{
+			auto Out = Container::insert(std::forward<ArgumentTypes>(Arguments)...);
+			Recount();
+			return Out;
+		}
+
+		template <typename ...ArgumentTypes> auto emplace(ArgumentTypes &&...Arguments) ->
+			decltype(std::declval<Container &>().emplace(std::forward<ArgumentTypes>(Arguments)...))
+		{
+			auto Out = Container::emplace(std::forward<ArgumentTypes>(Arguments)...);
+			Recount();
+			return Out;
+		}
+
 		void clear(void)
 		{
 			for (typename Container::iterator CurrentElement = Container::begin();
 				CurrentElement != Container::end(); CurrentElement++)
 				delete *CurrentElement;
 			Container::clear();
+			Recount();
 		}
 
 		typename Container::iterator erase(typename Container::iterator Value)
 		{
 			delete *Value;
-			return Container::erase(Value);
+			typename Container::iterator Out = Container::erase(Value);
+			Recount();
+			return Out;
 		}
 
 		bool erase(Type *Value)
@@ -135,6 +209,7 @@ template <class Type> class DeleterSet : public std::set<Type *, std::less<Type
 			{
 				delete *Found;
 				Container::erase(Found);
+				Recount();
 				return true;
 			}
 			else return false;
@@ -142,7 +217,9 @@ template <class Type> class DeleterSet : public std::set<Type *, std::less<Type
 
 		typename Container::iterator remove(typename Container::iterator Value)
 		{
-			return Container::erase(Value);
+			typename Container::iterator Out = Container::erase(Value);
+			Recount();
+			return Out;
 		}
 
 		bool remove(Type *Value)
@@ -151,13 +228,17 @@ template <class Type> class DeleterSet : public std::set<Type *, std::less<Type
 			if (Found != Container::end())
 			{
 				Container::erase(Found);
+				Recount();
 				return true;
 			}
 			else return false;
 		}
+
+	private:
+		void Recount(void) { DeleterAccount<Type>::Recount(Container::size()); }
 };
 
-template <class Type, class Base = std::deque<Type *> > class DeleterQueue : public std::queue<Type *, Base>
+template <class Type, class Base = std::deque<Type *> > class DeleterQueue : public std::queue<Type *, Base>, private DeleterAccount<Type>
 {
 	public:
 		typedef std::queue<Type *, Base> Container;
@@ -168,10 +249,17 @@ template <class Type, class Base = std::deque<Type *> > class DeleterQueue : pub
 				{ delete Container::front(); Container::pop(); }
 		}
 
+		template <typename ...ArgumentTypes> void push(ArgumentTypes &&...Arguments)
+			{ Container::push(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> void emplace(ArgumentTypes &&...Arguments)
+			{ Container::emplace(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
 		void clear(void)
 		{
 			while (!Container::empty())
 				{ delete Container::front(); Container::pop(); }
+			Recount();
 		}
 		
 		void pop(void)
@@ -180,11 +268,15 @@ template <class Type, class Base = std::deque<Type *> > class DeleterQueue : pub
 			{
 				delete Container::front();
 				Container::pop();
+				Recount();
 			}
 		}
+
+	private:
+		void Recount(void) { DeleterAccount<Type>::Recount(Container::size()); }
 };
 
-template <class Type, class Base = std::deque<Type *> > class DeleterStack : public std::stack<Type *, Base>
+template <class Type, class Base = std::deque<Type *> > class DeleterStack : public std::stack<Type *, Base>, private DeleterAccount<Type>
 {
 	public:
 		typedef std::stack<Type *, Base> Container;
@@ -195,10 +287,17 @@ template <class Type, class Base = std::deque<Type *> > class DeleterStack : pub
 				{ delete Container::top(); Container::pop(); }
 		}
 
+		template <typename ...ArgumentTypes> void push(ArgumentTypes &&...Arguments)
+			{ Container::push(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> void emplace(ArgumentTypes &&...Arguments)
+			{ Container::emplace(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
 		void clear(void)
 		{
 			while (!Container::empty())
 				{ delete Container::top(); Container::pop(); }
+			Recount();
 		}
 
 		void pop(void)
@@ -207,11 +306,15 @@ template <class Type, class Base = std::deque<Type *> > class DeleterStack : pub
 			{
 				delete Container::top();
 				Container::pop();
+				Recount();
 			}
 		}
+
+	private:
+		void Recount(void) { DeleterAccount<Type>::Recount(Container::size()); }
 };
 
-template <class Type> class DeleterDequeue : public std::deque<Type *>
+template <class Type> class DeleterDequeue : public std::deque<Type *>, private DeleterAccount<Type>
 {
 	public:
 		typedef std::deque<Type *> Container;
@@ -222,10 +325,31 @@ template <class Type> class DeleterDequeue : public std::deque<Type *>
 				{ delete Container::back(); Container::pop_back(); }
 		}
 
+		template <typename ...ArgumentTypes> void push_back(ArgumentTypes &&...Arguments)
+			{ Container::push_back(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> void push_front(ArgumentTypes &&...Arguments)
+			{ Container::push_front(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> void emplace_back(ArgumentTypes &&...Arguments)
+			{ Container::emplace_back(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> void emplace_front(ArgumentTypes &&...Arguments)
+			{ Container::emplace_front(std::forward<ArgumentTypes>(Arguments)...); Recount(); }
+
+		template <typename ...ArgumentTypes> auto insert(ArgumentTypes &&...Arguments) ->
+			decltype(std::declval<Container &>().insert(std::forward<ArgumentTypes>(Arguments)...))
+		{
+			auto Out = Container::insert(std::forward<ArgumentTypes>(Arguments)...);
+			Recount();
+			return Out;
+		}
+
 		void clear(void)
 		{
 			while (!Container::empty())
 				{ delete Container::back(); Container::pop_back(); }
+			Recount();
 		}
 
 		void pop_back(void)
@@ -234,6 +358,7 @@ template <class Type> class DeleterDequeue : public std::deque<Type *>
 			{
 				delete Container::back();
 				Container::pop_back();
+				Recount();
 			}
 		}
 
@@ -243,11 +368,15 @@ template <class Type> class DeleterDequeue : public std::deque<Type *>
 			{
 				delete Container::front();
 				Container::pop_front();
+				Recount();
 			}
 		}
+
+	private:
+		void Recount(void) { DeleterAccount<Type>::Recount(Container::size()); }
 };
 
-template <class Key, class Value> class DeleterMap : public std::map<Key, Value *>
+template <class Key, class Value> class DeleterMap : public std::map<Key, Value *>, private DeleterAccount<Value>
 {
 	public:
 		typedef std::map<Key, Value *> Container;
@@ -257,23 +386,377 @@ template <class Key, class Value> class DeleterMap : public std::map<Key, Value
 			for (typename Container::iterator CurrentItem = Container::begin(); CurrentItem != Container::end(); CurrentItem++)
 				delete CurrentItem->second;
 		}
+
+		template <typename ...ArgumentTypes> auto insert(ArgumentTypes &&...Arguments) ->
+			decltype(std::declval<Container &>().insert(std::forward<ArgumentTypes>(Arguments)...))
+		{
+			auto Out = Container::insert(std::forward<ArgumentTypes>(Arguments)...);
+			Recount();
+			return Out;
+		}
+
+		template <typename ...ArgumentTypes> auto emplace(ArgumentTypes &&...Arguments) ->
+			decltype(std::declval<Container &>().emplace(std::forward<ArgumentTypes>(Arguments)...))
+		{
+			auto Out = Container::emplace(std::forward<ArgumentTypes>(Arguments)...);
+			Recount();
+			return Out;
+		}
 		
 		void clear(void)
 		{
 			for (typename Container::iterator CurrentItem = Container::begin(); CurrentItem != Container::end(); CurrentItem++)
 				delete CurrentItem->second;
 			Container::clear();
+			Recount();
 		}
 		
 		void erase(typename Container::iterator Element)
 		{
 			delete Element->second;
 			Container::erase(Element);
+			Recount();
+		}
+
+	private:
+		void Recount(void) { DeleterAccount<Value>::Recount(Container::size()); }
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/////////////////////////////////// Arena - monotonic allocation, released all at once
+class Arena
+{
+	public:
+		Arena(size_t BlockSize = 4096) : BlockSize(BlockSize), Position(nullptr), Remaining(0) {}
+		Arena(Arena const &Other) = delete;
+		Arena &operator =(Arena const &Other) = delete;
+		~Arena(void) { for (auto Block : Blocks) FreeBlock(Block); }
+
+		void *Allocate(size_t Size, size_t Alignment = alignof(std::max_align_t))
+		{
+			size_t Padding = (Alignment - reinterpret_cast<uintptr_t>(Position) % Alignment) % Alignment;
+			if (Padding + Size > Remaining)
+			{
+				AddBlock(std::max(BlockSize, Size + Alignment));
+				Padding = (Alignment - reinterpret_cast<uintptr_t>(Position) % Alignment) % Alignment;
+			}
+			void *Out = Position + Padding;
+			Position += Padding + Size;
+			Remaining -= Padding + Size;
+			return Out;
+		}
+
+		template <typename Type, typename ...ArgumentTypes> Type *Make(ArgumentTypes &&...Arguments)
+			{ return new (Allocate(sizeof(Type), alignof(Type))) Type(std::forward<ArgumentTypes>(Arguments)...); }
+
+		// Forgets all allocations.  If the last cycle needed several blocks, they are replaced
+		// with one block large enough to hold them all.
+		void Reset(void)
+		{
+			if (Blocks.empty()) return;
+			if (Blocks.size() > 1)
+			{
+				size_t Total = 0;
+				for (auto Block : Blocks) { Total += Block.second; FreeBlock(Block); }
+				Blocks.clear();
+				AddBlock(Total);
+				return;
+			}
+			Position = Blocks.front().first;
+			Remaining = Blocks.front().second;
+		}
+
+	private:
+		void AddBlock(size_t Size)
+		{
+			char *Block = static_cast<char *>(malloc(Size));
+			if (Block == nullptr) throw std::bad_alloc();
+			Blocks.push_back(std::make_pair(Block, Size));
+			Accounting::Charge(Accounting::Tags::Arena(), Size);
+			Position = Block;
+			Remaining = Size;
+		}
+
+		static void FreeBlock(std::pair<char *, size_t> const &Block)
+		{
+			Accounting::Refund(Accounting::Tags::Arena(), Block.second);
+			free(Block.first);
+		}
+
+		size_t BlockSize;
+		char *Position;
+		size_t Remaining;
+		std::vector<std::pair<char *, size_t> > Blocks;
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+/////////////////////////////////// ArenaDeleter - members live in an arena owned by the container
+// Create members with Create rather than new.  Erasing a member runs its destructor but its memory
+// is only reclaimed when the container is cleared or destroyed.  Destructors are skipped for
+// trivially destructible types, or always if Destroy is false.
+template <bool Destroy> struct ArenaDisposal
+	{ template <typename Type> static void Dispose(Type *Target) { Target->~Type(); } };
+
+template <> struct ArenaDisposal<false>
+	{ template <typename Type> static void Dispose(Type *) {} };
+
+template <class Type, template<class Retype, class = std::allocator<Retype> > class Container, bool Destroy = !std::is_trivially_destructible<Type>::value>
+	class ArenaDeleterBase : public Container<Type *>
+{
+	public:
+		ArenaDeleterBase(size_t BlockSize = 4096) : Storage(BlockSize) {}
+
+		~ArenaDeleterBase(void) { DisposeAll(); }
+
+		template <typename ...ArgumentTypes> Type *Create(ArgumentTypes &&...Arguments)
+		{
+			Type *Out = Storage.template Make<Type>(std::forward<ArgumentTypes>(Arguments)...);
+			Container<Type *>::push_back(Out);
+			return Out;
+		}
+
+		void clear(void)
+		{
+			DisposeAll();
+			Container<Type *>::clear();
+			Storage.Reset();
+		}
+
+		// Forgets the members without destroying them.  Their memory still belongs to the arena, so
+		// they stay valid only until the container is cleared or destroyed.
+		void flush(void)
+		{
+			Container<Type *>::clear();
+		}
+
+		typename Container<Type *>::iterator erase(typename Container<Type *>::iterator Value)
+		{
+			ArenaDisposal<Destroy>::Dispose(*Value);
+			return Container<Type *>::erase(Value);
+		}
+
+		bool erase(Type *Value)
+		{
+			typename Container<Type *>::iterator Found =
+				find(Container<Type *>::begin(), Container<Type *>::end(), Value);
+			if (Found == Container<Type *>::end()) return false;
+			erase(Found);
+			return true;
+		}
+
+	private:
+		void DisposeAll(void)
+		{
+			if (!Destroy) return;
+			for (typename Container<Type *>::iterator CurrentElement = Container<Type *>::begin();
+				CurrentElement != Container<Type *>::end(); CurrentElement++)
+				ArenaDisposal<Destroy>::Dispose(*CurrentElement);
+		}
+
+		Arena Storage;
+};
+
+template <class Type> using ArenaDeleterList = ArenaDeleterBase<Type, std::list>;
+template <class Type> using ArenaDeleterVector = ArenaDeleterBase<Type, std::vector>;
+template <class Type, bool Destroy = !std::is_trivially_destructible<Type>::value> class ArenaDeleterDequeue :
+	public ArenaDeleterBase<Type, std::deque, Destroy>
+{
+	public:
+		typedef std::deque<Type *> Container;
+
+		ArenaDeleterDequeue(size_t BlockSize = 4096) : ArenaDeleterBase<Type, std::deque, Destroy>(BlockSize) {}
+
+		void pop_back(void)
+		{
+			if (Container::empty()) return;
+			ArenaDisposal<Destroy>::Dispose(Container::back());
+			Container::pop_back();
+		}
+
+		void pop_front(void)
+		{
+			if (Container::empty()) return;
+			ArenaDisposal<Destroy>::Dispose(Container::front());
+			Container::pop_front();
+		}
+};
+
+template <class Type, bool Destroy = !std::is_trivially_destructible<Type>::value> class ArenaDeleterSet : public std::set<Type *>
+{
+	public:
+		typedef std::set<Type *> Container;
+
+		ArenaDeleterSet(size_t BlockSize = 4096) : Storage(BlockSize) {}
+
+		~ArenaDeleterSet(void) { DisposeAll(); }
+
+		template <typename ...ArgumentTypes> Type *Create(ArgumentTypes &&...Arguments)
+		{
+			Type *Out = Storage.template Make<Type>(std::forward<ArgumentTypes>(Arguments)...);
+			Container::insert(Out);
+			return Out;
+		}
+
+		void clear(void)
+		{
+			DisposeAll();
+			Container::clear();
+			Storage.Reset();
+		}
+
+		typename Container::iterator erase(typename Container::iterator Value)
+		{
+			ArenaDisposal<Destroy>::Dispose(*Value);
+			return Container::erase(Value);
+		}
+
+		bool erase(Type *Value)
+		{
+			typename Container::iterator Found = Container::find(Value);
+			if (Found == Container::end()) return false;
+			erase(Found);
+			return true;
+		}
+
+	private:
+		void DisposeAll(void)
+		{
+			if (!Destroy) return;
+			for (typename Container::iterator CurrentElement = Container::begin();
+				CurrentElement != Container::end(); CurrentElement++)
+				ArenaDisposal<Destroy>::Dispose(*CurrentElement);
+		}
+
+		Arena Storage;
+};
+
+template <class Type, class Base = std::deque<Type *>, bool Destroy = !std::is_trivially_destructible<Type>::value> class ArenaDeleterQueue : public std::queue<Type *, Base>
+{
+	public:
+		typedef std::queue<Type *, Base> Container;
+
+		ArenaDeleterQueue(size_t BlockSize = 4096) : Storage(BlockSize) {}
+
+		~ArenaDeleterQueue(void) { DisposeAll(); }
+
+		template <typename ...ArgumentTypes> Type *Create(ArgumentTypes &&...Arguments)
+		{
+			Type *Out = Storage.template Make<Type>(std::forward<ArgumentTypes>(Arguments)...);
+			Container::push(Out);
+			return Out;
+		}
+
+		void clear(void)
+		{
+			DisposeAll();
+			Container::c.clear();
+			Storage.Reset();
+		}
+
+		void pop(void)
+		{
+			if (Container::empty()) return;
+			ArenaDisposal<Destroy>::Dispose(Container::front());
+			Container::pop();
+		}
+
+	private:
+		void DisposeAll(void)
+		{
+			if (!Destroy) return;
+			for (auto Element : Container::c) ArenaDisposal<Destroy>::Dispose(Element);
+		}
+
+		Arena Storage;
+};
+
+template <class Type, class Base = std::deque<Type *>, bool Destroy = !std::is_trivially_destructible<Type>::value> class ArenaDeleterStack : public std::stack<Type *, Base>
+{
+	public:
+		typedef std::stack<Type *, Base> Container;
+
+		ArenaDeleterStack(size_t BlockSize = 4096) : Storage(BlockSize) {}
+
+		~ArenaDeleterStack(void) { DisposeAll(); }
+
+		template <typename ...ArgumentTypes> Type *Create(ArgumentTypes &&...Arguments)
+		{
+			Type *Out = Storage.template Make<Type>(std::forward<ArgumentTypes>(Arguments)...);
+			Container::push(Out);
+			return Out;
+		}
+
+		void clear(void)
+		{
+			DisposeAll();
+			Container::c.clear();
+			Storage.Reset();
+		}
+
+		void pop(void)
+		{
+			if (Container::empty()) return;
+			ArenaDisposal<Destroy>::Dispose(Container::top());
+			Container::pop();
+		}
+
+	private:
+		void DisposeAll(void)
+		{
+			if (!Destroy) return;
+			for (auto Element : Container::c) ArenaDisposal<Destroy>::Dispose(Element);
+		}
+
+		Arena Storage;
+};
+
+template <class Key, class Value, bool Destroy = !std::is_trivially_destructible<Value>::value> class ArenaDeleterMap : public std::map<Key, Value *>
+{
+	public:
+		typedef std::map<Key, Value *> Container;
+
+		ArenaDeleterMap(size_t BlockSize = 4096) : Storage(BlockSize) {}
+
+		~ArenaDeleterMap(void) { DisposeAll(); }
+
+		// Replaces (and disposes) any value already stored at Index
+		template <typename ...ArgumentTypes> Value *Create(Key const &Index, ArgumentTypes &&...Arguments)
+		{
+			Value *Out = Storage.template Make<Value>(std::forward<ArgumentTypes>(Arguments)...);
+			Value *&Slot = Container::operator [](Index);
+			if (Slot != nullptr) ArenaDisposal<Destroy>::Dispose(Slot);
+			Slot = Out;
+			return Out;
+		}
+
+		void clear(void)
+		{
+			DisposeAll();
+			Container::clear();
+			Storage.Reset();
+		}
+
+		void erase(typename Container::iterator Element)
+		{
+			ArenaDisposal<Destroy>::Dispose(Element->second);
+			Container::erase(Element);
 		}
+
+	private:
+		void DisposeAll(void)
+		{
+			if (!Destroy) return;
+			for (typename Container::iterator CurrentItem = Container::begin(); CurrentItem != Container::end(); CurrentItem++)
+				ArenaDisposal<Destroy>::Dispose(CurrentItem->second);
+		}
+
+		Arena Storage;
 };
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 /////////////////////////////////// Cleaner - deletes members ready to die
+template <class BaseType> class EpochCleaner;
+
 template <class BaseType> class Cleaner : private std::vector<BaseType *>
 {
 	public:
@@ -284,6 +767,7 @@ template <class BaseType> class Cleaner : private std::vector<BaseType *>
 				void Destroy(void) { Destroyed = true; }
 			protected:
 				friend class Cleaner<BaseType>;
+				friend class EpochCleaner<BaseType>;
 				bool HasExpired(void) { return Destroyed; }
 			private:
 				bool Destroyed;
@@ -0,0 +1,108 @@
+#ifndef parallel_h
+#define parallel_h
+
+#include <vector>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <type_traits>
+#include <algorithm>
+#include <cstddef>
+
+#include "collection.h"
+#include "tasks.h"
+
+// ParallelFor splits [0, Count) into chunks of Grain indices and runs them as tasks on the default
+// scheduler, with the calling thread helping.  Body is called as Body(Start, End) for each chunk,
+// in no particular order, and must be safe to run concurrently.  The first exception thrown by a
+// chunk is rethrown once every chunk has stopped.  Calls may be nested.
+template <typename BodyType> void ParallelFor(size_t Count, size_t Grain, BodyType const &Body)
+{
+	if (Count == 0) return;
+	if (Grain == 0) Grain = 1;
+	size_t const ChunkCount = (Count + Grain - 1) / Grain;
+	Tasks::Scheduler &Workers = Tasks::DefaultScheduler();
+	if ((ChunkCount <= 1) || (Workers.GetWorkerCount() == 0))
+	{
+		Body(size_t(0), Count);
+		return;
+	}
+
+	// One task per worker claiming chunks in turn keeps spawning cheap for fine grains
+	std::atomic<size_t> NextChunk(0);
+	std::atomic<bool> Failed(false);
+	auto Work = [&](void)
+	{
+		size_t Chunk;
+		while (!Failed.load(std::memory_order_relaxed) &&
+			((Chunk = NextChunk.fetch_add(1, std::memory_order_relaxed)) < ChunkCount))
+		{
+			try { Body(Chunk * Grain, std::min(Count, (Chunk + 1) * Grain)); }
+			catch (...) { Failed.store(true); throw; }
+		}
+	};
+	Tasks::Group Chunks(Workers);
+	size_t const Helpers = std::min<size_t>(ChunkCount - 1, Workers.GetWorkerCount());
+	for (size_t Index = 0; Index < Helpers; Index++) Chunks.Run(Work);
+	std::exception_ptr Failure;
+	try { Work(); }
+	catch (...) { Failure = std::current_exception(); }
+	try { Chunks.Wait(); }
+	catch (...) { if (!Failure) Failure = std::current_exception(); }
+	if (Failure) std::rethrow_exception(Failure);
+}
+
+// Calls Body(Element) for every element of a random access range
+template <typename IteratorType, typename BodyType> void ParallelForEach(IteratorRange<IteratorType> Range, BodyType const &Body, size_t Grain = 64)
+{
+	static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<IteratorType>::iterator_category>::value,
+		"ParallelForEach needs random access iterators.");
+	IteratorType const Begin = Range.begin();
+	ParallelFor(static_cast<size_t>(Range.end() - Begin), Grain, [&Begin, &Body](size_t Start, size_t End)
+		{ for (IteratorType Position = Begin + Start, Stop = Begin + End; Position != Stop; ++Position) Body(*Position); });
+}
+
+// Calls Body(Element) for every element of an IndexIterable.  The core's GetValue must be safe to
+// call concurrently.
+template <typename CoreType, typename BodyType> void ParallelForEach(IndexIterable<CoreType> &Iterable, BodyType const &Body, size_t Grain = 64)
+{
+	ParallelFor(static_cast<size_t>(Iterable.GetCount()), Grain, [&Iterable, &Body](size_t Start, size_t End)
+		{ for (size_t Index = Start; Index < End; Index++) Body(Iterable.GetValue(Index)); });
+}
+
+// ParallelReduce folds Map(Index) over [0, Count) with Combine, starting each chunk from Identity.
+// Chunk results are combined in index order, so Combine only needs to be associative.
+template <typename ValueType, typename MapType, typename CombineType>
+	ValueType ParallelReduce(size_t Count, size_t Grain, ValueType const &Identity, MapType const &Map, CombineType const &Combine)
+{
+	if (Grain == 0) Grain = 1;
+	std::vector<ValueType> Partials((Count + Grain - 1) / Grain, Identity);
+	ParallelFor(Count, Grain, [&](size_t Start, size_t End)
+	{
+		ValueType Partial = Identity;
+		for (size_t Index = Start; Index < End; Index++) Partial = Combine(Partial, Map(Index));
+		Partials[Start / Grain] = Partial;
+	});
+	ValueType Out = Identity;
+	for (auto &Partial : Partials) Out = Combine(Out, Partial);
+	return Out;
+}
+
+template <typename IteratorType, typename ValueType, typename MapType, typename CombineType>
+	ValueType ParallelReduce(IteratorRange<IteratorType> Range, ValueType const &Identity, MapType const &Map, CombineType const &Combine, size_t Grain = 64)
+{
+	static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<IteratorType>::iterator_category>::value,
+		"ParallelReduce needs random access iterators.");
+	IteratorType const Begin = Range.begin();
+	return ParallelReduce(static_cast<size_t>(Range.end() - Begin), Grain, Identity,
+		[&Begin, &Map](size_t Index) { return Map(Begin[Index]); }, Combine);
+}
+
+template <typename CoreType, typename ValueType, typename MapType, typename CombineType>
+	ValueType ParallelReduce(IndexIterable<CoreType> &Iterable, ValueType const &Identity, MapType const &Map, CombineType const &Combine, size_t Grain = 64)
+{
+	return ParallelReduce(static_cast<size_t>(Iterable.GetCount()), Grain, Identity,
+		[&Iterable, &Map](size_t Index) { return Map(Iterable.GetValue(Index)); }, Combine);
+}
+
+#endif
@@ -2,9 +2,15 @@
 #define publicgood_h
 
 #include <map>
+#include <vector>
+#include <functional>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 
+#include "accounting.h"
+
 /*
 Pools manage the lifespans of widely shared objects.
 */
@@ -46,6 +52,7 @@ template <typename ReferenceType, class ItemType> class Pool
 				CurrentItem = Items.begin(); CurrentItem != Items.end(); CurrentItem++)
 			{
 				assert(CurrentItem->second->ShouldBeDeleted());
+				Accounting::Refund(Accounting::Tags::Pool(), sizeof(ItemType));
 				delete CurrentItem->second;
 			}
 		}
@@ -55,6 +62,7 @@ template <typename ReferenceType, class ItemType> class Pool
 			if (Items.find(Reference) == Items.end())
 			{
 				ItemType *Creation = new ItemType(Reference);
+				Accounting::Charge(Accounting::Tags::Pool(), sizeof(ItemType));
 				Items[Reference] = Creation;
 
 				return new Access<ItemType>(Creation);
@@ -64,7 +72,10 @@ template <typename ReferenceType, class ItemType> class Pool
 
 		void Add(const ReferenceType &Reference, ItemType *Addee)
 		{
-			Items[Reference] = Addee;
+			// A replaced item is no longer the pool's to delete, so the charge carries over to Addee
+			ItemType *&Slot = Items[Reference];
+			if (Slot == nullptr) Accounting::Charge(Accounting::Tags::Pool(), sizeof(ItemType));
+			Slot = Addee;
 		}
 
 		void Prune(void)
@@ -78,6 +89,7 @@ template <typename ReferenceType, class ItemType> class Pool
 				{
 					ReleasableItem = CurrentItem;
 					CurrentItem++;
+					Accounting::Refund(Accounting::Tags::Pool(), sizeof(ItemType));
 					delete ReleasableItem->second;
 					Items.erase(ReleasableItem);
 				}
@@ -88,4 +100,207 @@ template <typename ReferenceType, class ItemType> class Pool
 		std::map<ReferenceType, ItemType *> Items;
 };
 
+// ========================================================================
+// Budgeted pools
+
+// BudgetPools hash their references into an open-addressed table and keep unreferenced items
+// in least-recently-released order.  When the measured size of all items exceeds the budget,
+// the oldest unreferenced items are deleted first.  Items must derive from BudgetPoolItem.
+template <typename ReferenceType, class ItemType, class Hasher> class BudgetPool;
+
+template <typename ReferenceType, class ItemType> class BudgetPoolItem
+{
+	public:
+		BudgetPoolItem(void) : Bindings(0), Idle(nullptr), Listed(false), Previous(nullptr), Next(nullptr), PoolHash(0), Size(0) {}
+		void Reserve(void) { if ((Bindings++ == 0) && Listed) Unlink(); }
+		void Release(void) { assert(Bindings > 0); if ((--Bindings == 0) && (Idle != nullptr)) Append(); }
+	template <typename, class, class> friend class BudgetPool;
+	protected:
+		~BudgetPoolItem(void) {}
+		bool ShouldBeDeleted(void) { return Bindings <= 0; }
+	private:
+		struct IdleList { BudgetPoolItem *First, *Last; };
+
+		void Append(void)
+		{
+			assert(!Listed);
+			Previous = Idle->Last;
+			Next = nullptr;
+			if (Idle->Last != nullptr) Idle->Last->Next = this;
+			else Idle->First = this;
+			Idle->Last = this;
+			Listed = true;
+		}
+
+		void Unlink(void)
+		{
+			assert(Listed);
+			if (Previous != nullptr) Previous->Next = Next;
+			else Idle->First = Next;
+			if (Next != nullptr) Next->Previous = Previous;
+			else Idle->Last = Previous;
+			Previous = Next = nullptr;
+			Listed = false;
+		}
+
+		int Bindings;
+		IdleList *Idle;
+		bool Listed;
+		BudgetPoolItem *Previous, *Next;
+		ReferenceType PoolReference;
+		size_t PoolHash, Size;
+};
+
+template <typename ReferenceType, class ItemType, class Hasher = std::hash<ReferenceType> > class BudgetPool
+{
+	public:
+		typedef std::function<size_t(ItemType const &Item)> MeasureFunction;
+
+		// Without a measure function, every item has size 1 and the budget is an item count.
+		BudgetPool(size_t Budget, MeasureFunction const &Measure = MeasureFunction()) :
+			Budget(Budget), TotalSize(0), Count(0), Slots(16), Measure(Measure)
+			{ Idle.First = Idle.Last = nullptr; }
+
+		~BudgetPool(void)
+		{
+			for (auto &Slot : Slots)
+			{
+				if (Slot.Item == nullptr) continue;
+				assert(Slot.Item->ShouldBeDeleted());
+				Accounting::Refund(Accounting::Tags::Pool(), sizeof(ItemType));
+				delete Slot.Item;
+			}
+		}
+
+		Access<ItemType> Get(const ReferenceType &Reference)
+		{
+			size_t const Hash = Mix(Hasher()(Reference));
+			size_t Position = Find(Reference, Hash);
+			if (Slots[Position].Item != nullptr) return Access<ItemType>(Slots[Position].Item);
+
+			ItemType *Creation = new ItemType(Reference);
+			Insert(Position, Hash, Reference, Creation);
+			Access<ItemType> Out(Creation);
+			Trim();
+			return Out;
+		}
+
+		void Add(const ReferenceType &Reference, ItemType *Addee)
+		{
+			size_t const Hash = Mix(Hasher()(Reference));
+			size_t Position = Find(Reference, Hash);
+			assert(Slots[Position].Item == nullptr);
+			Insert(Position, Hash, Reference, Addee);
+			if (Addee->ShouldBeDeleted()) Addee->Append();
+			Trim();
+		}
+
+		bool Contains(const ReferenceType &Reference) const
+			{ return Slots[Find(Reference, Mix(Hasher()(Reference)))].Item != nullptr; }
+
+		// Deletes every unreferenced item, regardless of budget.
+		void Prune(void)
+			{ while (Idle.First != nullptr) Evict(); }
+
+		// Deletes unreferenced items, least recently released first, until the pool fits its budget.
+		void Trim(void)
+			{ while ((TotalSize > Budget) && (Idle.First != nullptr)) Evict(); }
+
+		void SetBudget(size_t NewBudget) { Budget = NewBudget; Trim(); }
+		size_t GetBudget(void) const { return Budget; }
+		size_t GetSize(void) const { return TotalSize; }
+		size_t GetCount(void) const { return Count; }
+
+	private:
+		struct Slot
+		{
+			Slot(void) : Item(nullptr), Hash(0) {}
+			ItemType *Item;
+			size_t Hash;
+		};
+
+		static size_t Mix(size_t Hash)
+		{
+			// Spread identity hashes (like std::hash<int>) across the high bits used for probing
+			uint64_t Mixed = static_cast<uint64_t>(Hash) * 0x9E3779B97F4A7C15ull;
+			return static_cast<size_t>(Mixed ^ (Mixed >> 32));
+		}
+
+		// Returns the slot holding Reference, or the empty slot where it would be inserted.
+		size_t Find(const ReferenceType &Reference, size_t Hash) const
+		{
+			size_t const Mask = Slots.size() - 1;
+			for (size_t Position = Hash & Mask; ; Position = (Position + 1) & Mask)
+			{
+				Slot const &Current = Slots[Position];
+				if (Current.Item == nullptr) return Position;
+				if ((Current.Hash == Hash) && (Current.Item->PoolReference == Reference)) return Position;
+			}
+		}
+
+		void Insert(size_t Position, size_t Hash, const ReferenceType &Reference, ItemType *Insertee)
+		{
+			if ((Count + 1) * 4 > Slots.size() * 3)
+			{
+				Grow();
+				Position = Find(Reference, Hash);
+			}
+			Slots[Position].Item = Insertee;
+			Slots[Position].Hash = Hash;
+			Count++;
+			Accounting::Charge(Accounting::Tags::Pool(), sizeof(ItemType));
+
+			Insertee->PoolReference = Reference;
+			Insertee->PoolHash = Hash;
+			Insertee->Idle = &Idle;
+			Insertee->Size = Measure ? Measure(*Insertee) : 1;
+			TotalSize += Insertee->Size;
+		}
+
+		void Grow(void)
+		{
+			std::vector<Slot> OldSlots(Slots.size() * 2);
+			OldSlots.swap(Slots);
+			size_t const Mask = Slots.size() - 1;
+			for (auto &Moving : OldSlots)
+			{
+				if (Moving.Item == nullptr) continue;
+				size_t Position = Moving.Hash & Mask;
+				while (Slots[Position].Item != nullptr) Position = (Position + 1) & Mask;
+				Slots[Position] = Moving;
+			}
+		}
+
+		void Evict(void)
+		{
+			ItemType *Evictee = static_cast<ItemType *>(Idle.First);
+			assert(Evictee->ShouldBeDeleted());
+			Evictee->Unlink();
+
+			// Backward-shift deletion keeps probe sequences intact without tombstones
+			size_t const Mask = Slots.size() - 1;
+			size_t Hole = Find(Evictee->PoolReference, Evictee->PoolHash);
+			for (size_t Position = (Hole + 1) & Mask; Slots[Position].Item != nullptr; Position = (Position + 1) & Mask)
+			{
+				size_t const Home = Slots[Position].Hash & Mask;
+				if (((Position - Home) & Mask) >= ((Position - Hole) & Mask))
+				{
+					Slots[Hole] = Slots[Position];
+					Hole = Position;
+				}
+			}
+			Slots[Hole] = Slot();
+			Count--;
+
+			TotalSize -= Evictee->Size;
+			Accounting::Refund(Accounting::Tags::Pool(), sizeof(ItemType));
+			delete Evictee;
+		}
+
+		size_t Budget, TotalSize, Count;
+		std::vector<Slot> Slots;
+		MeasureFunction Measure;
+		typename BudgetPoolItem<ReferenceType, ItemType>::IdleList Idle;
+};
+
 #endif
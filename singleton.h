@@ -3,6 +3,8 @@
 
 #include <cstdlib>
 #include <cassert>
+#include <atomic>
+#include <mutex>
 
 /* USAGE
 
@@ -47,4 +49,81 @@ template <class Derived> class Singleton
 
 template <class Derived> Derived *Singleton<Derived>::Instance = NULL;
 
+// Usage matches Singleton.  Get may be called from any thread and starts the instance if needed;
+// once started, Get is a single atomic load.  Stop must not race with other users.
+template <class Derived> class ConcurrentSingleton
+{
+	public:
+		~ConcurrentSingleton() {}
+
+		static void Start(void)
+		{
+			if (Instance.load(std::memory_order_acquire) != nullptr) return;
+			std::lock_guard<std::mutex> Lock(Mutex);
+			if (Instance.load(std::memory_order_relaxed) == nullptr) Instance.store(new Derived, std::memory_order_release);
+		}
+
+		static void Stop(void)
+		{
+			std::lock_guard<std::mutex> Lock(Mutex);
+			delete Instance.exchange(nullptr, std::memory_order_acq_rel);
+		}
+
+		static Derived &Get(void)
+		{
+			Derived *Out = Instance.load(std::memory_order_acquire);
+			if (Out != nullptr) return *Out;
+			Start();
+			return *Instance.load(std::memory_order_acquire);
+		}
+	protected:
+		ConcurrentSingleton() {}
+
+	private:
+		static std::atomic<Derived *> Instance;
+		static std::mutex Mutex;
+};
+
+template <class Derived> std::atomic<Derived *> ConcurrentSingleton<Derived>::Instance(nullptr);
+template <class Derived> std::mutex ConcurrentSingleton<Derived>::Mutex;
+
+// Usage matches Singleton, but each thread gets its own instance, created on the thread's first Get
+// and destroyed when the thread exits.  Suited to per-worker scratch buffers, random generators, etc.
+template <class Derived> class ThreadSingleton
+{
+	public:
+		~ThreadSingleton() {}
+
+		static Derived &Get(void)
+		{
+			Holder &Local = GetHolder();
+			if (Local.Instance == nullptr) Local.Instance = new Derived;
+			return *Local.Instance;
+		}
+
+		// Destroys the calling thread's instance early
+		static void Stop(void)
+		{
+			Holder &Local = GetHolder();
+			Destroy(Local.Instance);
+			Local.Instance = nullptr;
+		}
+	protected:
+		ThreadSingleton() {}
+
+	private:
+		struct Holder
+		{
+			Derived *Instance;
+			Holder(void) : Instance(nullptr) {}
+			~Holder(void) { Destroy(Instance); }
+		};
+		static void Destroy(Derived *Instance) { delete Instance; }
+		static Holder &GetHolder(void)
+		{
+			static thread_local Holder Local;
+			return Local;
+		}
+};
+
 #endif
@@ -4,6 +4,8 @@
 #include <cassert>
 #include <iostream>
 
+#include "parallel.h"
+
 namespace State
 {
 
@@ -42,4 +44,110 @@ void Machine::SetState(Base *NewState)
 	NextState = NewState;
 }
 
+// Machine sets
+MachineSet::StateID const MachineSet::Ended;
+
+MachineSet::MachineSet(bool Parallel) : Parallel(Parallel), Updating(false) {}
+
+MachineSet::StateID MachineSet::AddState(HandlerType const &Handler)
+{
+	assert(!Updating);
+	Groups.push_back(Group());
+	Groups.back().Handler = Handler;
+	return static_cast<StateID>(Groups.size() - 1);
+}
+
+MachineSet::AgentID MachineSet::Add(StateID Initial)
+{
+	assert(!Updating);
+	assert(Initial < Groups.size());
+	AgentID Added;
+	if (!FreeAgents.empty())
+	{
+		Added = FreeAgents.back();
+		FreeAgents.pop_back();
+	}
+	else
+	{
+		Added = static_cast<AgentID>(States.size());
+		States.push_back(Ended);
+		Positions.push_back(0);
+	}
+	States[Added] = Initial;
+	Positions[Added] = Groups[Initial].Members.size();
+	Groups[Initial].Members.push_back(Added);
+	return Added;
+}
+
+void MachineSet::SetState(AgentID Agent, StateID Next)
+{
+	assert(Agent < States.size());
+	assert(States[Agent] != Ended);
+	assert((Next == Ended) || (Next < Groups.size()));
+	Groups[States[Agent]].Transitions.push_back(std::make_pair(Agent, Next));
+}
+
+void MachineSet::End(AgentID Agent) { SetState(Agent, Ended); }
+
+MachineSet::StateID MachineSet::GetState(AgentID Agent) const
+	{ return Agent < States.size() ? States[Agent] : Ended; }
+
+size_t MachineSet::GetCount(StateID State) const { return Groups[State].Members.size(); }
+
+MachineSet::AgentID const *MachineSet::GetAgents(StateID State) const { return Groups[State].Members.data(); }
+
+void MachineSet::Update(void)
+{
+	Updating = true;
+	auto Run = [this](size_t Start, size_t End)
+	{
+		for (size_t State = Start; State < End; State++)
+		{
+			Group &Current = Groups[State];
+			if (Current.Members.empty() || !Current.Handler) continue;
+			Current.Handler(*this, static_cast<StateID>(State), Current.Members.data(), Current.Members.size());
+		}
+	};
+	try
+	{
+		if (Parallel) ParallelFor(Groups.size(), 1, Run);
+		else Run(0, Groups.size());
+	}
+	catch (...) { Updating = false; throw; }
+	Updating = false;
+	Commit();
+}
+
+void MachineSet::Commit(void)
+{
+	assert(!Updating);
+	// Requests are applied in state order, so the result doesn't depend on handler timing
+	for (auto &Requesting : Groups)
+	{
+		for (auto &Transition : Requesting.Transitions)
+		{
+			AgentID const Agent = Transition.first;
+			StateID const Previous = States[Agent];
+			if (Previous == Ended) continue; // Already ended by an earlier request
+			if (Previous == Transition.second) continue;
+
+			std::vector<AgentID> &Leaving = Groups[Previous].Members;
+			size_t const Position = Positions[Agent];
+			Leaving[Position] = Leaving.back();
+			Positions[Leaving[Position]] = Position;
+			Leaving.pop_back();
+
+			States[Agent] = Transition.second;
+			if (Transition.second == Ended) FreeAgents.push_back(Agent);
+			else
+			{
+				std::vector<AgentID> &Joining = Groups[Transition.second].Members;
+				Positions[Agent] = Joining.size();
+				Joining.push_back(Agent);
+			}
+		}
+		Requesting.Transitions.clear();
+	}
+}
+
 }
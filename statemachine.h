@@ -1,6 +1,14 @@
 #ifndef statemachine_h
 #define statemachine_h
 
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <cassert>
+
 namespace State
 {
 
@@ -22,6 +30,313 @@ class Machine
 		Base *NextState;
 };
 
+// ========================================================================
+// StaticMachine
+// A machine over a fixed list of state types.  States are constructed in place in one of two slots
+// inside the machine, so transitions never allocate, and updates dispatch on a type index rather
+// than a virtual call.
+//
+// States provide Update(Machine &) and optionally Enter(Machine &) and Exit(Machine &), usually as
+// member templates so they needn't name the machine type.  A state may name a Parent: a layer type
+// with optional static Enter, Exit and Update hooks shared by all its children.  Layers may have
+// parents of their own.  Moving between states exits layers up to the nearest shared one and enters
+// layers down to the new state; each update runs layer updates from the outermost in.
+//
+// Example:
+// struct Alert { template <typename Machine> static void Enter(Machine &) { Sound(); } };
+// struct Search { typedef Alert Parent; template <typename Machine> void Update(Machine &Brain); };
+// struct Chase { typedef Alert Parent; ... };
+// State::StaticMachine<Idle, Search, Chase> Brain;
+// Brain.SetState<Search>(); // Applied in the next Update, as with Machine
+namespace Static
+{
+	template <typename...> struct Void { typedef void Type; };
+
+	template <typename StateType, typename = void> struct ParentOf { typedef void Type; };
+	template <typename StateType> struct ParentOf<StateType, typename Void<typename StateType::Parent>::Type>
+		{ typedef typename StateType::Parent Type; };
+
+	// Whether Layer is StateType or one of its ancestors
+	template <typename Layer, typename StateType> struct Within : std::integral_constant<bool,
+		std::is_same<Layer, StateType>::value || Within<Layer, typename ParentOf<StateType>::Type>::value> {};
+	template <typename Layer> struct Within<Layer, void> : std::false_type {};
+
+	// Optional hooks
+	template <typename StateType, typename MachineType> auto Enter(StateType &Entered, MachineType &Machine, int) -> decltype(Entered.Enter(Machine), void())
+		{ Entered.Enter(Machine); }
+	template <typename StateType, typename MachineType> void Enter(StateType &, MachineType &, long) {}
+	template <typename StateType, typename MachineType> auto Exit(StateType &Exited, MachineType &Machine, int) -> decltype(Exited.Exit(Machine), void())
+		{ Exited.Exit(Machine); }
+	template <typename StateType, typename MachineType> void Exit(StateType &, MachineType &, long) {}
+	template <typename Layer, typename MachineType> auto EnterLayer(MachineType &Machine, int) -> decltype(Layer::Enter(Machine), void())
+		{ Layer::Enter(Machine); }
+	template <typename Layer, typename MachineType> void EnterLayer(MachineType &, long) {}
+	template <typename Layer, typename MachineType> auto ExitLayer(MachineType &Machine, int) -> decltype(Layer::Exit(Machine), void())
+		{ Layer::Exit(Machine); }
+	template <typename Layer, typename MachineType> void ExitLayer(MachineType &, long) {}
+	template <typename Layer, typename MachineType> auto UpdateLayer(MachineType &Machine, int) -> decltype(Layer::Update(Machine), void())
+		{ Layer::Update(Machine); }
+	template <typename Layer, typename MachineType> void UpdateLayer(MachineType &, long) {}
+
+	// Exits from Layer outwards, stopping at the first layer shared with Destination
+	template <typename Layer, typename Destination, bool Stop = std::is_same<Layer, void>::value || Within<Layer, Destination>::value> struct ExitLayers
+	{
+		template <typename MachineType> static void Run(MachineType &Machine)
+		{
+			ExitLayer<Layer>(Machine, 0);
+			ExitLayers<typename ParentOf<Layer>::Type, Destination>::Run(Machine);
+		}
+	};
+	template <typename Layer, typename Destination> struct ExitLayers<Layer, Destination, true>
+		{ template <typename MachineType> static void Run(MachineType &) {} };
+
+	// Enters layers down to Layer, starting below the last layer shared with Source
+	template <typename Layer, typename Source, bool Stop = std::is_same<Layer, void>::value || Within<Layer, Source>::value> struct EnterLayers
+	{
+		template <typename MachineType> static void Run(MachineType &Machine)
+		{
+			EnterLayers<typename ParentOf<Layer>::Type, Source>::Run(Machine);
+			EnterLayer<Layer>(Machine, 0);
+		}
+	};
+	template <typename Layer, typename Source> struct EnterLayers<Layer, Source, true>
+		{ template <typename MachineType> static void Run(MachineType &) {} };
+
+	template <typename Layer, bool Stop = std::is_same<Layer, void>::value> struct UpdateLayers
+	{
+		template <typename MachineType> static void Run(MachineType &Machine)
+		{
+			UpdateLayers<typename ParentOf<Layer>::Type>::Run(Machine);
+			UpdateLayer<Layer>(Machine, 0);
+		}
+	};
+	template <typename Layer> struct UpdateLayers<Layer, true>
+		{ template <typename MachineType> static void Run(MachineType &) {} };
+
+	// Calls Visit(State) with the state at Storage, whose type is number Target (from 1) in the list.
+	// Storage may be null where only the type matters.
+	template <size_t Index, typename... StateTypes> struct Dispatcher
+	{
+		template <typename VisitorType> static void Run(size_t, void *, VisitorType &) { assert(false); }
+	};
+	template <size_t Index, typename First, typename... Rest> struct Dispatcher<Index, First, Rest...>
+	{
+		template <typename VisitorType> static void Run(size_t Target, void *Storage, VisitorType &Visit)
+		{
+			if (Target == Index) Visit(static_cast<First *>(Storage));
+			else Dispatcher<Index + 1, Rest...>::Run(Target, Storage, Visit);
+		}
+	};
+
+	template <typename Type, typename... StateTypes> struct IndexOf;
+	template <typename Type, typename... Rest> struct IndexOf<Type, Type, Rest...> : std::integral_constant<size_t, 1> {};
+	template <typename Type, typename First, typename... Rest> struct IndexOf<Type, First, Rest...> :
+		std::integral_constant<size_t, 1 + IndexOf<Type, Rest...>::value> {};
+
+	template <typename... Types> struct Largest;
+	template <> struct Largest<> { static size_t const Size = 1, Alignment = 1; };
+	template <typename First, typename... Rest> struct Largest<First, Rest...>
+	{
+		static size_t const Size = sizeof(First) > Largest<Rest...>::Size ? sizeof(First) : Largest<Rest...>::Size;
+		static size_t const Alignment = alignof(First) > Largest<Rest...>::Alignment ? alignof(First) : Largest<Rest...>::Alignment;
+		// The largest size needn't be a multiple of the largest alignment, so pad consecutive slots
+		static size_t const Stride = (Size + Alignment - 1) / Alignment * Alignment;
+	};
+}
+
+template <typename... StateTypes> class StaticMachine
+{
+	typedef StaticMachine<StateTypes...> ThisType;
+	typedef Static::Dispatcher<1, StateTypes...> Dispatch;
+	static size_t const None = 0, Unchanged = size_t(-1);
+
+	public:
+		StaticMachine(void) : Current(0), CurrentIndex(None), PendingIndex(Unchanged), Applying(false) {}
+		~StaticMachine(void)
+		{
+			DestroyPending();
+			if (CurrentIndex != None) { Destroyer Destroy; Dispatch::Run(CurrentIndex, Slots[Current], Destroy); }
+		}
+		StaticMachine(ThisType const &Other) = delete;
+		ThisType &operator =(ThisType const &Other) = delete;
+
+		void Update(void)
+		{
+			if (CurrentIndex != None) { Updater Update {*this}; Dispatch::Run(CurrentIndex, Slots[Current], Update); }
+			Apply();
+		}
+
+		bool IsDone(void) const { return (CurrentIndex == None) && ((PendingIndex == Unchanged) || (PendingIndex == None)); }
+
+		// Replaces any transition not yet applied
+		template <typename NewState, typename... ArgumentTypes> void SetState(ArgumentTypes &&... Arguments)
+		{
+			assert(!Applying); // Not from Exit hooks
+			DestroyPending();
+			new (Slots[1 - Current]) NewState(std::forward<ArgumentTypes>(Arguments)...);
+			PendingIndex = Static::IndexOf<NewState, StateTypes...>::value;
+		}
+
+		void End(void)
+		{
+			DestroyPending();
+			PendingIndex = None;
+		}
+
+		// True if the current state is Type or lies under the layer Type
+		template <typename Type> bool IsIn(void)
+		{
+			if (CurrentIndex == None) return false;
+			Checker<Type> Check {false};
+			Dispatch::Run(CurrentIndex, Slots[Current], Check);
+			return Check.Found;
+		}
+
+		template <typename Type> Type *Get(void)
+		{
+			if (CurrentIndex != Static::IndexOf<Type, StateTypes...>::value) return nullptr;
+			return static_cast<Type *>(static_cast<void *>(Slots[Current]));
+		}
+
+	private:
+		struct Destroyer { template <typename Type> void operator()(Type *Destroyee) { Destroyee->~Type(); } };
+		struct Updater
+		{
+			ThisType &Machine;
+			template <typename Type> void operator()(Type *Updatee)
+			{
+				Static::UpdateLayers<typename Static::ParentOf<Type>::Type>::Run(Machine);
+				Updatee->Update(Machine);
+			}
+		};
+		template <typename Layer> struct Checker
+			{ bool Found; template <typename Type> void operator()(Type *) { Found = Static::Within<Layer, Type>::value; } };
+
+		// Transitions dispatch twice, once for each end, since layer hooks depend on both types
+		struct Exiter
+		{
+			ThisType &Machine;
+			template <typename OldState> void operator()(OldState *Exited)
+			{
+				Static::Exit(*Exited, Machine, 0);
+				if (Machine.PendingIndex == None) Static::ExitLayers<typename Static::ParentOf<OldState>::Type, void>::Run(Machine);
+				else { LayerExiter<OldState> ExitLayers {Machine}; Dispatch::Run(Machine.PendingIndex, nullptr, ExitLayers); }
+				Exited->~OldState();
+			}
+		};
+		template <typename OldState> struct LayerExiter
+		{
+			ThisType &Machine;
+			template <typename NewState> void operator()(NewState *)
+				{ Static::ExitLayers<typename Static::ParentOf<OldState>::Type, NewState>::Run(Machine); }
+		};
+		struct Entrant
+		{
+			ThisType &Machine;
+			size_t Previous;
+			template <typename NewState> void operator()(NewState *Entered)
+			{
+				if (Previous == None) Static::EnterLayers<typename Static::ParentOf<NewState>::Type, void>::Run(Machine);
+				else { LayerEntrant<NewState> EnterLayers {Machine}; Dispatch::Run(Previous, nullptr, EnterLayers); }
+				Static::Enter(*Entered, Machine, 0);
+			}
+		};
+		template <typename NewState> struct LayerEntrant
+		{
+			ThisType &Machine;
+			template <typename OldState> void operator()(OldState *)
+				{ Static::EnterLayers<typename Static::ParentOf<NewState>::Type, OldState>::Run(Machine); }
+		};
+
+		void Apply(void)
+		{
+			// Enter hooks may set another state, which applies straight after
+			while (PendingIndex != Unchanged)
+			{
+				size_t const Previous = CurrentIndex;
+				if (Previous != None)
+				{
+					Applying = true;
+					Exiter Exit {*this};
+					Dispatch::Run(Previous, Slots[Current], Exit);
+					Applying = false;
+				}
+
+				CurrentIndex = PendingIndex;
+				PendingIndex = Unchanged;
+				if (CurrentIndex == None) return;
+				Current = 1 - Current;
+				Entrant Enter {*this, Previous};
+				Dispatch::Run(CurrentIndex, Slots[Current], Enter);
+			}
+		}
+
+		void DestroyPending(void)
+		{
+			if ((PendingIndex == Unchanged) || (PendingIndex == None)) return;
+			Destroyer Destroy;
+			Dispatch::Run(PendingIndex, Slots[1 - Current], Destroy);
+			PendingIndex = Unchanged;
+		}
+
+		static_assert(Static::Largest<StateTypes...>::Stride % Static::Largest<StateTypes...>::Alignment == 0, "Second state slot would be misaligned");
+		alignas(Static::Largest<StateTypes...>::Alignment) unsigned char Slots[2][Static::Largest<StateTypes...>::Stride];
+		unsigned int Current;
+		size_t CurrentIndex, PendingIndex;
+		bool Applying;
+};
+
+// ========================================================================
+// MachineSet
+// Many small machines sharing states, stored as a state ID per agent with agents grouped by state.
+// Each update calls every state's handler once with all of the agents in that state.  Transitions
+// are queued and applied together in Commit, after the handlers have run, so handlers can iterate
+// their agents undisturbed.
+//
+// In parallel mode the handlers for different states run concurrently.  A handler may then only
+// change the states of agents in its own group.
+class MachineSet
+{
+	public:
+		typedef unsigned int StateID;
+		typedef unsigned int AgentID;
+		typedef std::function<void(MachineSet &Set, StateID State, AgentID const *Agents, size_t Count)> HandlerType;
+		static StateID const Ended = ~0u;
+
+		MachineSet(bool Parallel = false);
+
+		StateID AddState(HandlerType const &Handler);
+
+		// Not during Update.  IDs of ended agents are reused.
+		AgentID Add(StateID Initial);
+
+		// Takes effect at the next Commit.  Requests are applied by the agent's state at the time of
+		// the request, in state order, then in the order made.
+		void SetState(AgentID Agent, StateID Next);
+		void End(AgentID Agent);
+
+		StateID GetState(AgentID Agent) const;
+		size_t GetCount(StateID State) const;
+		AgentID const *GetAgents(StateID State) const;
+
+		void Update(void); // Runs each state's handler, then commits
+		void Commit(void);
+
+	private:
+		struct Group
+		{
+			HandlerType Handler;
+			std::vector<AgentID> Members;
+			std::vector<std::pair<AgentID, StateID> > Transitions; // Requested for members
+		};
+
+		bool Parallel, Updating;
+		std::vector<Group> Groups;
+		std::vector<StateID> States; // Per agent
+		std::vector<size_t> Positions; // Per agent, within its group's members
+		std::vector<AgentID> FreeAgents;
+};
+
 }
 
 #endif
@@ -0,0 +1,126 @@
+#include "stringbuilder.h"
+
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+#include "vector.h"
+#include "color.h"
+#include "filesystem.h"
+
+// Idle buffers for this thread.  Oversized buffers are dropped rather than kept forever.
+namespace
+{
+	size_t const KeepCapacity = 64 * 1024;
+
+	// Builders used during thread or program exit, after the pool is gone, allocate plainly
+	thread_local bool PoolGone = false;
+
+	struct BufferPool
+	{
+		std::vector<String *> Idle;
+		~BufferPool(void) { for (auto Buffer : Idle) delete Buffer; PoolGone = true; }
+	};
+
+	thread_local BufferPool LocalBuffers;
+}
+
+StringBuilder::StringBuilder(void)
+{
+	if (PoolGone || LocalBuffers.Idle.empty()) Buffer = new String;
+	else
+	{
+		Buffer = LocalBuffers.Idle.back();
+		LocalBuffers.Idle.pop_back();
+	}
+}
+
+StringBuilder::~StringBuilder(void)
+{
+	if (PoolGone || (Buffer->capacity() > KeepCapacity))
+	{
+		delete Buffer;
+		return;
+	}
+	Buffer->clear();
+	LocalBuffers.Idle.push_back(Buffer);
+}
+
+StringBuilder &StringBuilder::Append(char const *Text, size_t Length)
+	{ Buffer->append(Text, Length); return *this; }
+
+StringBuilder &StringBuilder::operator <<(char Data) { Buffer->push_back(Data); return *this; }
+
+StringBuilder &StringBuilder::operator <<(char const *Data) { return Append(Data, strlen(Data)); }
+
+StringBuilder &StringBuilder::operator <<(String const &Data) { return Append(Data.data(), Data.size()); }
+
+StringBuilder &StringBuilder::operator <<(StringBuilder const &Data) { return Append(Data.Data(), Data.Size()); }
+
+// Integers are written backwards into a scratch buffer, avoiding printf's format parsing
+template <typename Type> static void AppendUnsigned(String &Buffer, Type Data)
+{
+	char Digits[24];
+	char *Position = Digits + sizeof(Digits);
+	do
+	{
+		*--Position = static_cast<char>('0' + Data % 10);
+		Data /= 10;
+	} while (Data != 0);
+	Buffer.append(Position, Digits + sizeof(Digits) - Position);
+}
+
+template <typename Type, typename UnsignedType> static void AppendSigned(String &Buffer, Type Data)
+{
+	if (Data < 0)
+	{
+		Buffer.push_back('-');
+		AppendUnsigned(Buffer, static_cast<UnsignedType>(0) - static_cast<UnsignedType>(Data));
+	}
+	else AppendUnsigned(Buffer, static_cast<UnsignedType>(Data));
+}
+
+StringBuilder &StringBuilder::operator <<(int Data) { AppendSigned<int, unsigned int>(*Buffer, Data); return *this; }
+
+StringBuilder &StringBuilder::operator <<(unsigned int Data) { AppendUnsigned(*Buffer, Data); return *this; }
+
+StringBuilder &StringBuilder::operator <<(long int Data) { AppendSigned<long int, long unsigned int>(*Buffer, Data); return *this; }
+
+StringBuilder &StringBuilder::operator <<(long unsigned int Data) { AppendUnsigned(*Buffer, Data); return *this; }
+
+// %g matches the default stream formatting MemoryStream uses
+StringBuilder &StringBuilder::operator <<(float Data) { return *this << static_cast<double>(Data); }
+
+StringBuilder &StringBuilder::operator <<(double Data)
+{
+	char Digits[32];
+	int const Length = snprintf(Digits, sizeof(Digits), "%g", Data);
+	if (Length > 0) Append(Digits, static_cast<size_t>(Length));
+	return *this;
+}
+
+StringBuilder &StringBuilder::operator <<(Vector const &Data)
+	{ return *this << "(" << Data[0] << ", " << Data[1] << ", " << Data[2] << ")"; }
+
+StringBuilder &StringBuilder::operator <<(FlatVector const &Data)
+	{ return *this << "(" << Data[0] << ", " << Data[1] << ")"; }
+
+StringBuilder &StringBuilder::operator <<(Color const &Data)
+	{ return *this << "(C " << Data.Red << ", " << Data.Green << ", " << Data.Blue << ", " << Data.Alpha << ")"; }
+
+StringBuilder &StringBuilder::operator <<(Path const &Data)
+	{ Data.AppendAbsoluteString(*this); return *this; }
+
+char const *StringBuilder::Data(void) const { return Buffer->data(); }
+
+char const *StringBuilder::CString(void) const { return Buffer->c_str(); }
+
+size_t StringBuilder::Size(void) const { return Buffer->size(); }
+
+bool StringBuilder::Empty(void) const { return Buffer->empty(); }
+
+void StringBuilder::Clear(void) { Buffer->clear(); }
+
+String StringBuilder::AsString(void) const { return String(Buffer->data(), Buffer->size()); }
+
+StringBuilder::operator String(void) const { return AsString(); }
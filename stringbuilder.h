@@ -0,0 +1,64 @@
+#ifndef stringbuilder_h
+#define stringbuilder_h
+
+#include <cstddef>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "string.h"
+
+class Vector;
+class FlatVector;
+class Color;
+class Path;
+template <typename Type> class Range;
+
+// Assembles text in a buffer borrowed from a per-thread pool, so building a message costs no
+// allocations once the pool is warm, and producing the final String costs one.  Builders may be
+// nested; each borrows its own buffer.  Numbers are formatted the same way as MemoryStream.
+class StringBuilder
+{
+	public:
+		StringBuilder(void);
+		~StringBuilder(void);
+		StringBuilder(StringBuilder const &Other) = delete;
+		StringBuilder &operator =(StringBuilder const &Other) = delete;
+
+		StringBuilder &Append(char const *Text, size_t Length);
+
+		StringBuilder &operator <<(char Data);
+		StringBuilder &operator <<(char const *Data);
+		StringBuilder &operator <<(String const &Data);
+		StringBuilder &operator <<(StringBuilder const &Data);
+		StringBuilder &operator <<(int Data);
+		StringBuilder &operator <<(unsigned int Data);
+		StringBuilder &operator <<(long int Data);
+		StringBuilder &operator <<(long unsigned int Data);
+		StringBuilder &operator <<(float Data);
+		StringBuilder &operator <<(double Data);
+		StringBuilder &operator <<(Vector const &Data);
+		StringBuilder &operator <<(FlatVector const &Data);
+		StringBuilder &operator <<(Color const &Data);
+		StringBuilder &operator <<(Path const &Data);
+		template <typename Type> StringBuilder &operator <<(Range<Type> const &Data)
+			{ return *this << "[" << Data.Min << ", " << Data.Max << "]"; }
+
+		char const *Data(void) const; // Not null terminated
+		char const *CString(void) const; // Null terminated, for system calls
+		size_t Size(void) const;
+		bool Empty(void) const;
+		void Clear(void);
+
+		String AsString(void) const;
+		operator String(void) const;
+#if __cplusplus >= 201703L
+		// Valid until the builder is changed or destroyed
+		std::string_view AsStringView(void) const { return std::string_view(Data(), Size()); }
+#endif
+
+	private:
+		String *Buffer;
+};
+
+#endif
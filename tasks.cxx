@@ -0,0 +1,327 @@
+#include "tasks.h"
+
+#include <cassert>
+
+#ifdef WINDOWS
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Tasks
+{
+
+// ========================================================================
+// Deque
+// Lê, Pop, Cohen and Zappa Nardelli's C11 formulation, with the fences folded into the
+// neighbouring operations.
+
+Deque::Ring::Ring(int64_t Capacity) : Capacity(Capacity), Slots(new std::atomic<Task *>[Capacity]) {}
+
+Deque::Deque(void) : Top(0), Bottom(0)
+{
+	Rings.emplace_back(new Ring(256));
+	Array.store(Rings.back().get(), std::memory_order_relaxed);
+}
+
+Deque::~Deque(void) { assert(Empty()); }
+
+void Deque::Push(Task *Pushee)
+{
+	int64_t const CurrentBottom = Bottom.load(std::memory_order_relaxed);
+	int64_t const CurrentTop = Top.load(std::memory_order_acquire);
+	Ring *Current = Array.load(std::memory_order_relaxed);
+	if (CurrentBottom - CurrentTop > Current->Capacity - 1)
+	{
+		Ring *Grown = new Ring(Current->Capacity * 2);
+		for (int64_t Index = CurrentTop; Index < CurrentBottom; Index++)
+			(*Grown)[Index].store((*Current)[Index].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		Rings.emplace_back(Grown);
+		Array.store(Grown, std::memory_order_release);
+		Current = Grown;
+	}
+	(*Current)[CurrentBottom].store(Pushee, std::memory_order_relaxed);
+	Bottom.store(CurrentBottom + 1, std::memory_order_release);
+}
+
+Task *Deque::Pop(void)
+{
+	int64_t const CurrentBottom = Bottom.load(std::memory_order_relaxed) - 1;
+	Ring *Current = Array.load(std::memory_order_relaxed);
+	Bottom.store(CurrentBottom, std::memory_order_seq_cst);
+	int64_t CurrentTop = Top.load(std::memory_order_seq_cst);
+	if (CurrentTop > CurrentBottom)
+	{
+		Bottom.store(CurrentBottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Task *Out = (*Current)[CurrentBottom].load(std::memory_order_relaxed);
+	if (CurrentTop == CurrentBottom)
+	{
+		// Last task; race thieves for it
+		if (!Top.compare_exchange_strong(CurrentTop, CurrentTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			Out = nullptr;
+		Bottom.store(CurrentBottom + 1, std::memory_order_relaxed);
+	}
+	return Out;
+}
+
+Task *Deque::Steal(void)
+{
+	int64_t CurrentTop = Top.load(std::memory_order_seq_cst);
+	int64_t const CurrentBottom = Bottom.load(std::memory_order_seq_cst);
+	if (CurrentTop >= CurrentBottom) return nullptr;
+
+	Ring *Current = Array.load(std::memory_order_acquire);
+	Task *Out = (*Current)[CurrentTop].load(std::memory_order_relaxed);
+	if (!Top.compare_exchange_strong(CurrentTop, CurrentTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return Out;
+}
+
+bool Deque::Empty(void) const
+	{ return Bottom.load(std::memory_order_acquire) <= Top.load(std::memory_order_acquire); }
+
+// ========================================================================
+// Scheduler
+
+static thread_local Scheduler *CurrentScheduler = nullptr;
+static thread_local int CurrentWorker = -1;
+
+static uint32_t NextRandom(uint32_t &Seed)
+{
+	Seed ^= Seed << 13;
+	Seed ^= Seed >> 17;
+	Seed ^= Seed << 5;
+	return Seed;
+}
+
+Scheduler::Scheduler(unsigned int WorkerCount, bool Pin) : Queued(0), Sleepers(0), Stopping(false)
+{
+	if (WorkerCount == 0) WorkerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	for (unsigned int Index = 0; Index < WorkerCount; Index++)
+	{
+		Workers.emplace_back(new Worker);
+		Workers.back()->Seed = 0x9E3779B9u * (Index + 1);
+	}
+	// Start only once every deque exists, since workers steal from each other
+	for (unsigned int Index = 0; Index < WorkerCount; Index++)
+		Workers[Index]->Thread = std::thread([this, Index, Pin](void) { WorkerMain(static_cast<int>(Index), Pin); });
+}
+
+Scheduler::~Scheduler(void)
+{
+	{
+		std::lock_guard<std::mutex> Lock(SleepMutex);
+		Stopping.store(true);
+	}
+	Wake.notify_all();
+	for (auto &Current : Workers) Current->Thread.join();
+	while (RunOne()) {}
+}
+
+unsigned int Scheduler::GetWorkerCount(void) const { return static_cast<unsigned int>(Workers.size()); }
+
+void Scheduler::Spawn(std::function<void(void)> const &Work) { Submit(new Task(Work, nullptr)); }
+
+bool Scheduler::RunOne(void)
+{
+	static thread_local uint32_t Seed = 0x2545F491u;
+	Task *Found = Find((CurrentScheduler == this) ? CurrentWorker : -1, Seed);
+	if (Found == nullptr) return false;
+	Execute(Found);
+	return true;
+}
+
+void Scheduler::Submit(Task *Submission)
+{
+	Queued.fetch_add(1, std::memory_order_seq_cst);
+	if ((CurrentScheduler == this) && (CurrentWorker >= 0)) Workers[CurrentWorker]->Local.Push(Submission);
+	else
+	{
+		std::lock_guard<std::mutex> Lock(InjectionMutex);
+		Injection.push_back(Submission);
+	}
+
+	// Sleepers register before checking Queued, so one side always sees the other
+	if (Sleepers.load(std::memory_order_seq_cst) > 0)
+	{
+		{ std::lock_guard<std::mutex> Lock(SleepMutex); }
+		Wake.notify_one();
+	}
+}
+
+Task *Scheduler::Find(int Self, uint32_t &Seed)
+{
+	Task *Found = nullptr;
+	if (Self >= 0) Found = Workers[Self]->Local.Pop();
+
+	if (Found == nullptr)
+	{
+		std::lock_guard<std::mutex> Lock(InjectionMutex);
+		if (!Injection.empty())
+		{
+			Found = Injection.front();
+			Injection.pop_front();
+		}
+	}
+
+	if ((Found == nullptr) && !Workers.empty())
+	{
+		size_t const Count = Workers.size();
+		size_t const Start = NextRandom(Seed) % Count;
+		for (size_t Offset = 0; (Found == nullptr) && (Offset < Count); Offset++)
+		{
+			size_t const Victim = (Start + Offset) % Count;
+			if (static_cast<int>(Victim) != Self) Found = Workers[Victim]->Local.Steal();
+		}
+	}
+
+	if (Found != nullptr) Queued.fetch_sub(1, std::memory_order_relaxed);
+	return Found;
+}
+
+void Scheduler::Execute(Task *Executee)
+{
+	std::exception_ptr Failure;
+	try { Executee->Work(); }
+	catch (...) { Failure = std::current_exception(); }
+
+	// Release the task's captures before the group can be seen to finish
+	Group *Owner = Executee->Owner;
+	delete Executee;
+	if (Owner != nullptr) Owner->Finish(Failure);
+	else assert(!Failure); // Ungrouped tasks have nowhere to report to
+}
+
+void Scheduler::WorkerMain(int Self, bool Pin)
+{
+	CurrentScheduler = this;
+	CurrentWorker = Self;
+	if (Pin)
+	{
+		unsigned int const Core = static_cast<unsigned int>(Self) % std::max(1u, std::thread::hardware_concurrency());
+#ifdef WINDOWS
+		SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << (Core % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+		cpu_set_t Cores;
+		CPU_ZERO(&Cores);
+		CPU_SET(Core, &Cores);
+		pthread_setaffinity_np(pthread_self(), sizeof(Cores), &Cores);
+#else
+		(void)Core;
+#endif
+	}
+
+	uint32_t &Seed = Workers[Self]->Seed;
+	while (true)
+	{
+		Task *Found = Find(Self, Seed);
+		for (unsigned int Spin = 0; (Found == nullptr) && (Spin < 64); Spin++)
+		{
+			std::this_thread::yield();
+			Found = Find(Self, Seed);
+		}
+		if (Found != nullptr)
+		{
+			Execute(Found);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> Lock(SleepMutex);
+		if (Stopping.load() && (Queued.load() <= 0)) return;
+		Sleepers.fetch_add(1, std::memory_order_seq_cst);
+		Wake.wait(Lock, [this](void) { return Stopping.load() || (Queued.load(std::memory_order_seq_cst) > 0); });
+		Sleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+Scheduler &DefaultScheduler(void)
+{
+	static Scheduler DefaultSchedulerInstance;
+	return DefaultSchedulerInstance;
+}
+
+// ========================================================================
+// Group
+
+Group::Group(Scheduler &Owner) : Owner(Owner), Pending(0) {}
+
+Group::~Group(void)
+{
+	while (Pending.load(std::memory_order_acquire) > 0)
+		if (!Owner.RunOne()) std::this_thread::yield();
+	std::lock_guard<std::mutex> Lock(Mutex); // Lets the last Settle release the mutex
+}
+
+void Group::Run(std::function<void(void)> const &Work)
+{
+	Pending.fetch_add(1, std::memory_order_acq_rel);
+	Owner.Submit(new Task(Work, this));
+}
+
+void Group::Wait(void)
+{
+	while (Pending.load(std::memory_order_acquire) > 0)
+		if (!Owner.RunOne()) std::this_thread::yield();
+
+	std::exception_ptr Rethrown;
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Rethrown = Failure;
+		Failure = nullptr;
+	}
+	if (Rethrown) std::rethrow_exception(Rethrown);
+}
+
+void Group::Then(std::function<void(void)> const &Continuation)
+{
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (Pending.load(std::memory_order_acquire) > 0)
+		{
+			Continuations.push_back(Continuation);
+			return;
+		}
+		Pending.fetch_add(1, std::memory_order_acq_rel);
+	}
+	Owner.Submit(new Task(Continuation, this));
+}
+
+bool Group::IsIdle(void) const { return Pending.load(std::memory_order_acquire) == 0; }
+
+void Group::Finish(std::exception_ptr const &Failure)
+{
+	if (Failure)
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (!this->Failure) this->Failure = Failure;
+	}
+	Settle();
+}
+
+void Group::Settle(void)
+{
+	// Only the last task takes the lock, so Then can't miss the group going idle
+	int Current = Pending.load(std::memory_order_acquire);
+	while (Current > 1)
+		if (Pending.compare_exchange_weak(Current, Current - 1, std::memory_order_acq_rel)) return;
+
+	std::vector<std::function<void(void)> > Ready;
+	Scheduler &Target = Owner;
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+		if (!Continuations.empty())
+		{
+			Pending.fetch_add(static_cast<int>(Continuations.size()), std::memory_order_acq_rel);
+			Ready.swap(Continuations);
+		}
+		Pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+	// If anything was ready the group is still pending, so it's still alive
+	for (auto &Continuation : Ready) Target.Submit(new Task(Continuation, this));
+}
+
+}
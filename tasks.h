@@ -0,0 +1,150 @@
+#ifndef tasks_h
+#define tasks_h
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+
+/*
+A work-stealing task scheduler.
+
+Each worker owns a Chase-Lev deque: it pushes and pops its own tasks at the bottom, newest first,
+while idle workers steal the oldest tasks from the top.  Tasks spawned from other threads go to a
+shared injection queue.  Workers with nothing to do spin briefly, then sleep until more work is
+spawned.
+
+Groups track a batch of tasks.  Waiting on a group runs pending tasks on the waiting thread rather
+than blocking, so groups may be waited on from inside tasks.
+*/
+
+namespace Tasks
+{
+
+class Group;
+
+struct Task
+{
+	Task(std::function<void(void)> const &Work, Group *Owner) : Work(Work), Owner(Owner) {}
+	std::function<void(void)> Work;
+	Group *Owner;
+};
+
+// Only the owning worker may Push and Pop; any thread may Steal
+class Deque
+{
+	public:
+		Deque(void);
+		~Deque(void);
+		Deque(Deque const &Other) = delete;
+		Deque &operator =(Deque const &Other) = delete;
+
+		void Push(Task *Pushee);
+		Task *Pop(void);
+		Task *Steal(void);
+		bool Empty(void) const;
+
+	private:
+		struct Ring
+		{
+			Ring(int64_t Capacity);
+			int64_t const Capacity;
+			std::unique_ptr<std::atomic<Task *>[]> Slots;
+			std::atomic<Task *> &operator [](int64_t Index) { return Slots[Index & (Capacity - 1)]; }
+		};
+
+		// Padded apart so thieves hitting Top don't slow the owner's Bottom
+		std::atomic<int64_t> Top;
+		char Padding[64 - sizeof(std::atomic<int64_t>)];
+		std::atomic<int64_t> Bottom;
+		std::atomic<Ring *> Array;
+		std::vector<std::unique_ptr<Ring> > Rings; // Outgrown rings stay alive for late thieves
+};
+
+class Scheduler
+{
+	public:
+		// 0 workers is one less than the hardware threads.  Pinning binds each worker to one core.
+		Scheduler(unsigned int WorkerCount = 0, bool Pin = false);
+		~Scheduler(void); // Runs remaining tasks before returning
+		Scheduler(Scheduler const &Other) = delete;
+		Scheduler &operator =(Scheduler const &Other) = delete;
+
+		unsigned int GetWorkerCount(void) const;
+
+		// Tasks without a group must not throw
+		void Spawn(std::function<void(void)> const &Work);
+
+		// Runs one pending task on the calling thread.  Returns false if none could be found.
+		bool RunOne(void);
+
+	private:
+		friend class Group;
+		struct Worker
+		{
+			Deque Local;
+			std::thread Thread;
+			uint32_t Seed;
+		};
+
+		void Submit(Task *Submission);
+		Task *Find(int Self, uint32_t &Seed);
+		void Execute(Task *Executee);
+		void WorkerMain(int Self, bool Pin);
+
+		std::vector<std::unique_ptr<Worker> > Workers;
+
+		std::mutex InjectionMutex;
+		std::deque<Task *> Injection;
+
+		std::atomic<int64_t> Queued;
+		std::atomic<int> Sleepers;
+		std::mutex SleepMutex;
+		std::condition_variable Wake;
+		std::atomic<bool> Stopping;
+};
+
+Scheduler &DefaultScheduler(void);
+
+class Group
+{
+	public:
+		Group(Scheduler &Owner = DefaultScheduler());
+		~Group(void); // Waits, discarding any failure
+		Group(Group const &Other) = delete;
+		Group &operator =(Group const &Other) = delete;
+
+		void Run(std::function<void(void)> const &Work);
+
+		// Returns once every task and continuation has finished, running pending tasks meanwhile.
+		// Rethrows the first exception thrown by a task since the last Wait.
+		void Wait(void);
+
+		// Runs Continuation as a task of this group once the group's tasks have all finished, or
+		// right away if none are pending.
+		void Then(std::function<void(void)> const &Continuation);
+
+		bool IsIdle(void) const;
+
+	private:
+		friend class Scheduler;
+		void Finish(std::exception_ptr const &Failure);
+		void Settle(void);
+
+		Scheduler &Owner;
+		std::atomic<int> Pending;
+		std::mutex Mutex;
+		std::exception_ptr Failure;
+		std::vector<std::function<void(void)> > Continuations;
+};
+
+}
+
+#endif
@@ -12,35 +12,30 @@ Clock::~Clock(void)
 
 void Clock::UpdateDifference(const unsigned int MillisecondStep)
 {
-	if (Paused) return;
-
-	LastTime = CurrentTime;
-	CurrentTime += MillisecondStep;
-	TimeStep = float(CurrentTime - LastTime) / 1000.0f;
-	
-	Unpaused += CurrentTime - LastTime;
+	UpdateAbsolute(CurrentTime.load() + MillisecondStep);
 }
 
 void Clock::UpdateAbsolute(const unsigned int Milliseconds)
 {
-	if (Paused) return;
+	if (Paused.load()) return;
 
-	LastTime = CurrentTime;
-	CurrentTime = Milliseconds;
-	TimeStep = float(CurrentTime - LastTime) / 1000.0f;
+	unsigned int const Previous = CurrentTime.load();
+	LastTime.store(Previous);
+	CurrentTime.store(Milliseconds);
+	TimeStep.store(float(Milliseconds - Previous) / 1000.0f);
 	
-	Unpaused += CurrentTime - LastTime;
+	Unpaused.fetch_add(Milliseconds - Previous);
 }
 
 float Clock::Step(void) const
-	{ return (!Paused) ? TimeStep : 0.0f; }
+	{ return (!Paused.load()) ? TimeStep.load() : 0.0f; }
 
 unsigned int Clock::Milliseconds(void) 
-	{ return CurrentTime; }
+	{ return CurrentTime.load(); }
 
 float Clock::UnpausedSeconds(void)
 {
-	return Unpaused * 0.001f;
+	return Unpaused.load() * 0.001f;
 }
 
 void Clock::Pause(void)
@@ -50,8 +45,9 @@ void Clock::Pause(void)
 
 void Clock::Unpause(void)
 {
-	--Paused;
-	Paused = std::max(Paused, 0);
+	// Never below 0, as before
+	int Current = Paused.load();
+	while ((Current > 0) && !Paused.compare_exchange_weak(Current, Current - 1)) {}
 }
 
 // Timer wrapper thing
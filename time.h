@@ -1,13 +1,19 @@
 #ifndef time_h
 #define time_h
 
+#include <atomic>
+
 #include "singleton.h"
 
-class Clock : public Singleton<Clock>
+class Clock : public ConcurrentSingleton<Clock>
 {
 	// This class controls the flow of time, and allows others to query it
 	// through its Step function and Singleton interface.
-	friend class Singleton<Clock>;
+
+	// Any thread may read the clock or pause it, but updates should come from one thread.  Each
+	// value is read atomically; a reader racing an update may see Step and Milliseconds from
+	// different updates.  Unlike Singleton, Get starts the clock if it hasn't been started.
+	friend class ConcurrentSingleton<Clock>;
 	protected: 
 		Clock(void);
 		~Clock(void);
@@ -23,11 +29,11 @@ class Clock : public Singleton<Clock>
 		void Unpause(void);
 
 	private:
-		float TimeStep;
-		unsigned int LastTime, CurrentTime;
-		unsigned int Unpaused;
+		std::atomic<float> TimeStep;
+		std::atomic<unsigned int> LastTime, CurrentTime;
+		std::atomic<unsigned int> Unpaused;
 
-		int Paused;
+		std::atomic<int> Paused;
 };
 
 
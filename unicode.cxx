@@ -0,0 +1,416 @@
+#include "unicode.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define UNICODE_X86
+#include <immintrin.h>
+#endif
+
+#include "exception.h"
+#include "cpu.h"
+
+namespace Unicode
+{
+
+// ========================================================================
+// Helpers
+
+// Length of the leading run of ASCII, checked a block at a time
+static size_t SkipASCII(unsigned char const *Text, size_t Length)
+{
+	size_t Position = 0;
+#ifdef __SSE2__
+	for (; Position + 16 <= Length; Position += 16)
+	{
+		int const HighBits = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(Text + Position)));
+		if (HighBits != 0)
+		{
+			while (!(HighBits & (1 << (Position & 15)))) Position++; // Fall out at the first non-ASCII byte
+			return Position;
+		}
+	}
+#endif
+	while ((Position < Length) && (Text[Position] < 0x80)) Position++;
+	return Position;
+}
+
+static unsigned int CountBits(unsigned int Bits)
+{
+	unsigned int Count = 0;
+	for (; Bits != 0; Bits &= Bits - 1) Count++;
+	return Count;
+}
+
+// Decodes one sequence starting with a non-ASCII byte, rejecting anything Unicode calls
+// ill-formed.  Returns the sequence length, or 0 if invalid.
+static size_t DecodeUTF8(unsigned char const *Text, size_t Remaining, uint32_t &Point)
+{
+	unsigned char const Lead = Text[0];
+	size_t Length;
+	uint32_t Minimum;
+	if ((Lead >= 0xC2) && (Lead <= 0xDF)) { Length = 2; Point = Lead & 0x1F; Minimum = 0x80; }
+	else if ((Lead & 0xF0) == 0xE0) { Length = 3; Point = Lead & 0x0F; Minimum = 0x800; }
+	else if ((Lead >= 0xF0) && (Lead <= 0xF4)) { Length = 4; Point = Lead & 0x07; Minimum = 0x10000; }
+	else return 0;
+	if (Remaining < Length) return 0;
+
+	for (size_t Index = 1; Index < Length; Index++)
+	{
+		if ((Text[Index] & 0xC0) != 0x80) return 0;
+		Point = (Point << 6) | (Text[Index] & 0x3F);
+	}
+	if ((Point < Minimum) || (Point > 0x10FFFF) || ((Point >= 0xD800) && (Point <= 0xDFFF))) return 0;
+	return Length;
+}
+
+static size_t EncodeUTF8(uint32_t Point, char *Out)
+{
+	if (Point < 0x80) { Out[0] = static_cast<char>(Point); return 1; }
+	if (Point < 0x800)
+	{
+		Out[0] = static_cast<char>(0xC0 | (Point >> 6));
+		Out[1] = static_cast<char>(0x80 | (Point & 0x3F));
+		return 2;
+	}
+	if (Point < 0x10000)
+	{
+		Out[0] = static_cast<char>(0xE0 | (Point >> 12));
+		Out[1] = static_cast<char>(0x80 | ((Point >> 6) & 0x3F));
+		Out[2] = static_cast<char>(0x80 | (Point & 0x3F));
+		return 3;
+	}
+	Out[0] = static_cast<char>(0xF0 | (Point >> 18));
+	Out[1] = static_cast<char>(0x80 | ((Point >> 12) & 0x3F));
+	Out[2] = static_cast<char>(0x80 | ((Point >> 6) & 0x3F));
+	Out[3] = static_cast<char>(0x80 | (Point & 0x3F));
+	return 4;
+}
+
+// ========================================================================
+// Validation
+
+#ifdef UNICODE_X86
+// Classifies each byte pair by lookup tables on the high and low nibble of the first byte and the
+// high nibble of the second (Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction
+// Per Byte").  A bit survives the and of the three lookups only if the pair is an error, except
+// for TwoContinuations, which must match whether the byte is the third or fourth of a sequence.
+namespace Classes
+{
+	uint8_t const TooShort = 1 << 0; // Lead followed by a lead or ASCII
+	uint8_t const TooLong = 1 << 1; // ASCII followed by a continuation
+	uint8_t const Overlong3 = 1 << 2;
+	uint8_t const TooLarge = 1 << 3;
+	uint8_t const Surrogate = 1 << 4;
+	uint8_t const Overlong2 = 1 << 5;
+	uint8_t const TooLarge1000 = 1 << 6;
+	uint8_t const Overlong4 = 1 << 6;
+	uint8_t const TwoContinuations = 1 << 7;
+	uint8_t const Carry = TooShort | TooLong | TwoContinuations;
+}
+
+__attribute__((target("sse4.2"))) static inline __m128i Lookup(__m128i Nibbles, __m128i Table)
+	{ return _mm_shuffle_epi8(Table, Nibbles); }
+
+__attribute__((target("sse4.2"))) static inline __m128i HighNibbles(__m128i Block)
+	{ return _mm_and_si128(_mm_srli_epi16(Block, 4), _mm_set1_epi8(0x0F)); }
+
+// Nonzero bytes where Block is an error, given the 16 bytes before it
+__attribute__((target("sse4.2"))) static inline __m128i CheckBlock(__m128i Block, __m128i Previous)
+{
+	using namespace Classes;
+	__m128i const Previous1 = _mm_alignr_epi8(Block, Previous, 15);
+	__m128i const FirstHigh = Lookup(HighNibbles(Previous1), _mm_setr_epi8(
+		TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+		TwoContinuations, TwoContinuations, TwoContinuations, TwoContinuations,
+		TooShort | Overlong2, TooShort, TooShort | Overlong3 | Surrogate,
+		static_cast<char>(TooShort | TooLarge | TooLarge1000 | Overlong4)));
+	char const Large = TooLarge | TooLarge1000;
+	__m128i const FirstLow = Lookup(_mm_and_si128(Previous1, _mm_set1_epi8(0x0F)), _mm_setr_epi8(
+		static_cast<char>(Carry | Overlong3 | Overlong2 | Overlong4), static_cast<char>(Carry | Overlong2),
+		static_cast<char>(Carry), static_cast<char>(Carry),
+		static_cast<char>(Carry | TooLarge), static_cast<char>(Carry | Large),
+		static_cast<char>(Carry | Large), static_cast<char>(Carry | Large),
+		static_cast<char>(Carry | Large), static_cast<char>(Carry | Large),
+		static_cast<char>(Carry | Large), static_cast<char>(Carry | Large),
+		static_cast<char>(Carry | Large), static_cast<char>(Carry | Large | Surrogate),
+		static_cast<char>(Carry | Large), static_cast<char>(Carry | Large)));
+	char const Continuation = TooLong | Overlong2 | TwoContinuations;
+	__m128i const SecondHigh = Lookup(HighNibbles(Block), _mm_setr_epi8(
+		TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+		static_cast<char>(Continuation | Overlong3 | TooLarge1000 | Overlong4),
+		static_cast<char>(Continuation | Overlong3 | TooLarge),
+		static_cast<char>(Continuation | Surrogate | TooLarge),
+		static_cast<char>(Continuation | Surrogate | TooLarge),
+		TooShort, TooShort, TooShort, TooShort));
+	__m128i const Special = _mm_and_si128(_mm_and_si128(FirstHigh, FirstLow), SecondHigh);
+
+	// Bytes 2 or 3 after a 3 or 4 byte lead must be continuations
+	__m128i const Third = _mm_subs_epu8(_mm_alignr_epi8(Block, Previous, 14), _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+	__m128i const Fourth = _mm_subs_epu8(_mm_alignr_epi8(Block, Previous, 13), _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+	__m128i const Expected = _mm_and_si128(_mm_or_si128(Third, Fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+	return _mm_xor_si128(Expected, Special);
+}
+
+// Nonzero if Block ends partway through a sequence
+__attribute__((target("sse4.2"))) static inline __m128i CheckEnd(__m128i Block)
+{
+	return _mm_subs_epu8(Block, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1)));
+}
+
+// Length of the leading run of 16 byte blocks known to be valid, short of any sequence cut off at
+// the end of the run.  The scalar decoder takes over from there.
+__attribute__((target("sse4.2"))) static size_t SkipValidSSE42(unsigned char const *Text, size_t Length)
+{
+	__m128i Previous = _mm_setzero_si128(), Incomplete = _mm_setzero_si128();
+	size_t Position = 0;
+	for (; Position + 16 <= Length; Position += 16)
+	{
+		__m128i const Block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Text + Position));
+		__m128i Error;
+		if (_mm_movemask_epi8(Block) != 0)
+		{
+			Error = CheckBlock(Block, Previous);
+			Incomplete = CheckEnd(Block);
+		}
+		else
+		{
+			// CheckBlock catches unfinished sequences, but is skipped for ASCII
+			Error = Incomplete;
+			Incomplete = _mm_setzero_si128();
+		}
+		if (!_mm_testz_si128(Error, Error)) break;
+		Previous = Block;
+	}
+
+	// Back up to the lead of the last sequence, which the good blocks may not have finished
+	size_t Start = Position;
+	while ((Start > 0) && (Position - Start < 4) && ((Text[Start - 1] & 0xC0) == 0x80)) Start--;
+	if ((Start > 0) && (Position - Start < 4) && (Text[Start - 1] >= 0xC0)) Start--;
+	return Start;
+}
+#endif
+
+size_t FindInvalidUTF8(char const *Text, size_t Length)
+{
+	unsigned char const *Bytes = reinterpret_cast<unsigned char const *>(Text);
+	size_t Position = 0;
+#ifdef UNICODE_X86
+	if (CPU::GetLevel() >= CPU::Level::SSE42) Position = SkipValidSSE42(Bytes, Length);
+#endif
+	while (Position < Length)
+	{
+		Position += SkipASCII(Bytes + Position, Length - Position);
+		// Decode non-ASCII until ASCII resumes, then go back to skipping blocks
+		while ((Position < Length) && (Bytes[Position] >= 0x80))
+		{
+			uint32_t Point;
+			size_t const Decoded = DecodeUTF8(Bytes + Position, Length - Position, Point);
+			if (Decoded == 0) return Position;
+			Position += Decoded;
+		}
+	}
+	return Length;
+}
+
+bool IsValidUTF8(char const *Text, size_t Length) { return FindInvalidUTF8(Text, Length) == Length; }
+
+// ========================================================================
+// Length prediction
+
+size_t UTF16LengthOfUTF8(char const *Text, size_t Length)
+{
+	// One unit per sequence lead, plus one more for each 4 byte lead
+	size_t Position = 0, Count = 0;
+#ifdef __SSE2__
+	__m128i const ContinuationLimit = _mm_set1_epi8(-65), FourLimit = _mm_set1_epi8(-17), Zero = _mm_setzero_si128();
+	for (; Position + 16 <= Length; Position += 16)
+	{
+		__m128i const Block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Text + Position));
+		Count += CountBits(_mm_movemask_epi8(_mm_cmpgt_epi8(Block, ContinuationLimit)));
+		Count += CountBits(_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(Block, FourLimit), _mm_cmplt_epi8(Block, Zero))));
+	}
+#endif
+	for (; Position < Length; Position++)
+	{
+		unsigned char const Byte = static_cast<unsigned char>(Text[Position]);
+		if ((Byte & 0xC0) != 0x80) Count++;
+		if (Byte >= 0xF0) Count++;
+	}
+	return Count;
+}
+
+size_t UTF32LengthOfUTF8(char const *Text, size_t Length)
+{
+	size_t Position = 0, Count = 0;
+#ifdef __SSE2__
+	__m128i const ContinuationLimit = _mm_set1_epi8(-65);
+	for (; Position + 16 <= Length; Position += 16)
+		Count += CountBits(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(Text + Position)), ContinuationLimit)));
+#endif
+	for (; Position < Length; Position++)
+		if ((static_cast<unsigned char>(Text[Position]) & 0xC0) != 0x80) Count++;
+	return Count;
+}
+
+size_t UTF8LengthOfUTF16(char16_t const *Text, size_t Length)
+{
+	size_t Count = 0;
+	for (size_t Position = 0; Position < Length; Position++)
+	{
+		char16_t const Unit = Text[Position];
+		if (Unit < 0x80) Count += 1;
+		else if (Unit < 0x800) Count += 2;
+		else if ((Unit >= 0xD800) && (Unit <= 0xDBFF)) Count += 4; // The low surrogate adds nothing
+		else if ((Unit >= 0xDC00) && (Unit <= 0xDFFF)) {}
+		else Count += 3;
+	}
+	return Count;
+}
+
+size_t UTF8LengthOfUTF32(char32_t const *Text, size_t Length)
+{
+	size_t Count = 0;
+	for (size_t Position = 0; Position < Length; Position++)
+		Count += (Text[Position] < 0x80) ? 1 : (Text[Position] < 0x800) ? 2 : (Text[Position] < 0x10000) ? 3 : 4;
+	return Count;
+}
+
+// ========================================================================
+// Conversion
+
+size_t UTF8ToUTF16(char const *Text, size_t Length, char16_t *Out)
+{
+	unsigned char const *Bytes = reinterpret_cast<unsigned char const *>(Text);
+	size_t Position = 0, Written = 0;
+	while (Position < Length)
+	{
+#ifdef __SSE2__
+		// Widen whole ASCII blocks
+		__m128i const Zero = _mm_setzero_si128();
+		for (; Position + 16 <= Length; Position += 16, Written += 16)
+		{
+			__m128i const Block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Bytes + Position));
+			if (_mm_movemask_epi8(Block) != 0) break;
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Written), _mm_unpacklo_epi8(Block, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Written + 8), _mm_unpackhi_epi8(Block, Zero));
+		}
+		if (Position >= Length) break;
+#endif
+		if (Bytes[Position] < 0x80)
+		{
+			Out[Written++] = Bytes[Position++];
+			continue;
+		}
+		uint32_t Point;
+		size_t const Decoded = DecodeUTF8(Bytes + Position, Length - Position, Point);
+		if (Decoded == 0) return Invalid;
+		Position += Decoded;
+		if (Point < 0x10000) Out[Written++] = static_cast<char16_t>(Point);
+		else
+		{
+			Point -= 0x10000;
+			Out[Written++] = static_cast<char16_t>(0xD800 | (Point >> 10));
+			Out[Written++] = static_cast<char16_t>(0xDC00 | (Point & 0x3FF));
+		}
+	}
+	return Written;
+}
+
+size_t UTF8ToUTF32(char const *Text, size_t Length, char32_t *Out)
+{
+	unsigned char const *Bytes = reinterpret_cast<unsigned char const *>(Text);
+	size_t Position = 0, Written = 0;
+	while (Position < Length)
+	{
+#ifdef __SSE2__
+		__m128i const Zero = _mm_setzero_si128();
+		for (; Position + 16 <= Length; Position += 16, Written += 16)
+		{
+			__m128i const Block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Bytes + Position));
+			if (_mm_movemask_epi8(Block) != 0) break;
+			__m128i const Low = _mm_unpacklo_epi8(Block, Zero), High = _mm_unpackhi_epi8(Block, Zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Written), _mm_unpacklo_epi16(Low, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Written + 4), _mm_unpackhi_epi16(Low, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Written + 8), _mm_unpacklo_epi16(High, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(Out + Written + 12), _mm_unpackhi_epi16(High, Zero));
+		}
+		if (Position >= Length) break;
+#endif
+		if (Bytes[Position] < 0x80)
+		{
+			Out[Written++] = Bytes[Position++];
+			continue;
+		}
+		uint32_t Point;
+		size_t const Decoded = DecodeUTF8(Bytes + Position, Length - Position, Point);
+		if (Decoded == 0) return Invalid;
+		Position += Decoded;
+		Out[Written++] = Point;
+	}
+	return Written;
+}
+
+size_t UTF16ToUTF8(char16_t const *Text, size_t Length, char *Out)
+{
+	size_t Position = 0, Written = 0;
+	while (Position < Length)
+	{
+#ifdef __SSE2__
+		// Narrow blocks of 8 ASCII units
+		__m128i const NonASCII = _mm_set1_epi16(static_cast<short>(0xFF80));
+		for (; Position + 8 <= Length; Position += 8, Written += 8)
+		{
+			__m128i const Block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(Text + Position));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(Block, NonASCII), _mm_setzero_si128())) != 0xFFFF) break;
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(Out + Written), _mm_packus_epi16(Block, Block));
+		}
+		if (Position >= Length) break;
+#endif
+		uint32_t Point = Text[Position++];
+		if ((Point >= 0xD800) && (Point <= 0xDBFF))
+		{
+			if ((Position >= Length) || (Text[Position] < 0xDC00) || (Text[Position] > 0xDFFF)) return Invalid;
+			Point = 0x10000 + ((Point - 0xD800) << 10) + (Text[Position++] - 0xDC00);
+		}
+		else if ((Point >= 0xDC00) && (Point <= 0xDFFF)) return Invalid;
+		Written += EncodeUTF8(Point, Out + Written);
+	}
+	return Written;
+}
+
+size_t UTF32ToUTF8(char32_t const *Text, size_t Length, char *Out)
+{
+	size_t Written = 0;
+	for (size_t Position = 0; Position < Length; Position++)
+	{
+		uint32_t const Point = Text[Position];
+		if ((Point > 0x10FFFF) || ((Point >= 0xD800) && (Point <= 0xDFFF))) return Invalid;
+		Written += EncodeUTF8(Point, Out + Written);
+	}
+	return Written;
+}
+
+// ========================================================================
+// Wrappers
+
+template <typename OutputType, typename InputType, typename PredictType, typename ConvertType>
+	static OutputType Convert(InputType const &Input, PredictType Predict, ConvertType Transcode)
+{
+	OutputType Out;
+	Out.resize(Predict(Input.data(), Input.size()));
+	size_t const Written = Transcode(Input.data(), Input.size(), &Out[0]);
+	if (Written == Invalid) throw Error::Input("Text is not valid Unicode.");
+	Out.resize(Written); // Predictions overshoot if the input was bad partway
+	return Out;
+}
+
+std::u16string AsUTF16(String const &Text) { return Convert<std::u16string>(Text, UTF16LengthOfUTF8, UTF8ToUTF16); }
+std::u32string AsUTF32(String const &Text) { return Convert<std::u32string>(Text, UTF32LengthOfUTF8, UTF8ToUTF32); }
+String AsUTF8(std::u16string const &Text) { return Convert<String>(Text, UTF8LengthOfUTF16, UTF16ToUTF8); }
+String AsUTF8(std::u32string const &Text) { return Convert<String>(Text, UTF8LengthOfUTF32, UTF32ToUTF8); }
+
+}
@@ -0,0 +1,44 @@
+#ifndef unicode_h
+#define unicode_h
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "string.h"
+
+// Bulk UTF-8, UTF-16 and UTF-32 validation and conversion.  UTF-8 validation checks 16 bytes at a
+// time, multi-byte sequences included, when the CPU level is SSE4.2 or better.  The conversions
+// only have an ASCII fast path: ASCII runs, the common case for our text, are widened and narrowed
+// 16 bytes at a time with SSE2, and other sequences are decoded one at a time.
+//
+// The buffer functions write to caller storage sized with the matching length prediction, which
+// assumes valid input.  They return the number of code units written, or Invalid if the input is
+// malformed (overlong UTF-8, surrogates, unpaired UTF-16 surrogates, points above U+10FFFF).
+namespace Unicode
+{
+	size_t const Invalid = ~size_t(0);
+
+	bool IsValidUTF8(char const *Text, size_t Length);
+	inline bool IsValidUTF8(String const &Text) { return IsValidUTF8(Text.data(), Text.size()); }
+	size_t FindInvalidUTF8(char const *Text, size_t Length); // Offset of the first bad sequence, or Length
+
+	// Length predictions, in code units of the output
+	size_t UTF16LengthOfUTF8(char const *Text, size_t Length);
+	size_t UTF32LengthOfUTF8(char const *Text, size_t Length);
+	size_t UTF8LengthOfUTF16(char16_t const *Text, size_t Length);
+	size_t UTF8LengthOfUTF32(char32_t const *Text, size_t Length);
+
+	size_t UTF8ToUTF16(char const *Text, size_t Length, char16_t *Out);
+	size_t UTF8ToUTF32(char const *Text, size_t Length, char32_t *Out);
+	size_t UTF16ToUTF8(char16_t const *Text, size_t Length, char *Out);
+	size_t UTF32ToUTF8(char32_t const *Text, size_t Length, char *Out);
+
+	// Convenience wrappers that allocate once.  Invalid input throws Error::Input.
+	std::u16string AsUTF16(String const &Text);
+	std::u32string AsUTF32(String const &Text);
+	String AsUTF8(std::u16string const &Text);
+	String AsUTF8(std::u32string const &Text);
+}
+
+#endif
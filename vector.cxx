@@ -3,7 +3,7 @@
 #include <math.h>
 #include <cassert>
 
-#include "inputoutput.h"
+#include "stringbuilder.h"
 
 // Vector 3D =======================================================================================
 // Operators - base operations
@@ -40,11 +40,7 @@ Vector::Vector(const FlatVector &Operand, const float z)
 
 // TO STRINGGG
 String Vector::AsString(void) const
-{
-	MemoryStream Out;
-	Out << "(" << Data[0] << ", " << Data[1] << ", " << Data[2] << ")";
-	return Out;
-}
+	{ return StringBuilder() << *this; }
 
 // MEMBER OPERATORS
 Vector Vector::operator + (const Vector &Operand) const
@@ -217,11 +213,7 @@ FlatVector::FlatVector(const Vector &Operand)
 }
 
 String FlatVector::AsString(void) const
-{
-	MemoryStream Out;
-	Out << "(" << Data[0] << ", " << Data[1] << ")";
-	return Out;
-}
+	{ return StringBuilder() << *this; }
 
 FlatVector FlatVector::operator + (const FlatVector &Operand) const
 {